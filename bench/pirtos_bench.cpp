@@ -0,0 +1,998 @@
+// pirtos_bench: microbenchmarks for the core primitives. Results are written
+// as JSON so runs from different builds can be diffed for regressions.
+//
+//   pirtos_bench                       # all suites, JSON to stdout
+//   pirtos_bench --json out.json       # write results to a file
+//   pirtos_bench --filter ring --quick # subset, shorter runs
+
+#include "Cover.hpp"
+#include "CoverPosix.hpp"
+#include "EventCapture.hpp"
+#include "RingBuffer.hpp"
+#include "Scheduler.hpp"
+#include "Task.hpp"
+#include "Tmp102Sensor.hpp"
+
+#include "data_logger.h"
+#include "fixed_point.h"
+#include "latency_histogram.h"
+#include "network_manager.h"
+#include "reactor.h"
+#include "report_filter.h"
+#include "time_aligner.h"
+#include "sensor_manager.h"
+#include "shm_channel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, double>> values;
+};
+
+class Reporter {
+public:
+    explicit Reporter(bool quick) : quick_(quick) {}
+
+    bool quick() const { return quick_; }
+    double seconds(double full) const { return quick_ ? full / 5.0 : full; }
+
+    void add(std::string name, std::vector<std::pair<std::string, double>> values) {
+        std::cerr << "  " << name;
+        for (auto& kv : values) std::cerr << " " << kv.first << "=" << kv.second;
+        std::cerr << std::endl;
+        results_.push_back({std::move(name), std::move(values)});
+    }
+
+    // Suites that also verify correctness report violations here; the run
+    // then exits non-zero.
+    void fail(const std::string& why) {
+        std::cerr << "  FAIL: " << why << std::endl;
+        failed_ = true;
+    }
+    bool failed() const { return failed_; }
+
+    void write_json(std::ostream& out) const {
+        out << "{\n  \"suite\": \"pirtos_bench\",\n  \"quick\": "
+            << (quick_ ? "true" : "false") << ",\n  \"passed\": "
+            << (failed_ ? "false" : "true") << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const Result& r = results_[i];
+            out << "    {\"name\": \"" << r.name << "\"";
+            for (auto& kv : r.values) {
+                out << ", \"" << kv.first << "\": ";
+                if (std::isfinite(kv.second)) out << kv.second;
+                else out << "null";
+            }
+            out << "}" << (i + 1 < results_.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    bool quick_;
+    bool failed_ = false;
+    std::vector<Result> results_;
+};
+
+// Swallows logger/network output while still paying the formatting cost.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+class CoutSilencer {
+public:
+    CoutSilencer() : saved_(std::cout.rdbuf(&null_)) {}
+    ~CoutSilencer() { std::cout.rdbuf(saved_); }
+private:
+    NullBuffer null_;
+    std::streambuf* saved_;
+};
+
+double elapsed_s(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+}
+
+// ---------------------------------------------------------------------------
+// RingBuffer push/pop with N producers and N consumers on one buffer.
+
+void bench_ringbuffer(Reporter& rep) {
+    for (int threads : {1, 2, 4}) {
+        RingBuffer<uint64_t> rb(1024);
+        std::atomic<bool> go{false}, stop{false};
+        std::atomic<uint64_t> pushed{0}, popped{0}, push_full{0};
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([&] {
+                while (!go) std::this_thread::yield();
+                uint64_t n = 0, full = 0;
+                while (!stop) {
+                    if (rb.push(n)) ++n;
+                    else ++full;
+                }
+                pushed += n;
+                push_full += full;
+            });
+            workers.emplace_back([&] {
+                while (!go) std::this_thread::yield();
+                uint64_t n = 0;
+                while (!stop) {
+                    if (rb.pop()) ++n;
+                }
+                popped += n;
+            });
+        }
+
+        auto t0 = Clock::now();
+        go = true;
+        std::this_thread::sleep_for(std::chrono::duration<double>(rep.seconds(1.0)));
+        stop = true;
+        for (auto& w : workers) w.join();
+        double secs = elapsed_s(t0);
+
+        rep.add("ringbuffer.contended",
+                {{"producers", threads}, {"consumers", threads},
+                 {"push_per_s", pushed / secs}, {"pop_per_s", popped / secs},
+                 {"full_ratio", pushed ? double(push_full) / (push_full + pushed) : 0.0}});
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scheduler wakeup latency/jitter: each task measures how late each run starts
+// relative to its ideal release time (first run + k * period).
+
+class ProbeTask : public Task {
+public:
+    explicit ProbeTask(std::chrono::milliseconds period) : period_(period) {}
+    const char* name() const override { return "probe"; }
+    std::chrono::milliseconds period() const override { return period_; }
+    void run() override {
+        auto now = Clock::now();
+        if (runs_ == 0) first_ = now;
+        auto ideal = first_ + period_ * runs_;
+        auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(now - ideal).count();
+        hist_.record(late > 0 ? static_cast<uint64_t>(late) : 0);
+        ++runs_;
+    }
+    const LatencyHistogram& histogram() const { return hist_; }
+
+private:
+    std::chrono::milliseconds period_;
+    Clock::time_point first_;
+    uint64_t runs_ = 0;
+    LatencyHistogram hist_;
+};
+
+void bench_scheduler(Reporter& rep) {
+    const auto period = std::chrono::milliseconds(1);
+    for (int count : {1, 4, 16, 64}) {
+        std::vector<std::unique_ptr<ProbeTask>> tasks;
+        Scheduler sched;
+        for (int i = 0; i < count; ++i) {
+            tasks.push_back(std::make_unique<ProbeTask>(period));
+            sched.add(tasks.back().get());
+        }
+        sched.start();
+        std::this_thread::sleep_for(std::chrono::duration<double>(rep.seconds(2.0)));
+        sched.stop();
+
+        LatencyHistogram all;
+        for (auto& t : tasks) all.merge(t->histogram());
+
+        rep.add("scheduler.wakeup",
+                {{"tasks", count}, {"period_us", 1000}, {"runs", double(all.count())},
+                 {"late_p50_us", all.percentile(50) / 1e3},
+                 {"late_p99_us", all.percentile(99) / 1e3},
+                 {"jitter_us", (all.percentile(99) - all.percentile(1)) / 1e3},
+                 {"late_max_us", all.max() / 1e3}});
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SensorManager::read_sensors snapshot cost, idle and with the update thread
+// writing as fast as a synthetic source can produce.
+
+void bench_read_sensors(Reporter& rep) {
+    CoutSilencer quiet;
+    for (double writer_hz : {0.0, 1e6}) {
+        SyntheticConfig cfg;
+        cfg.rate_hz = writer_hz > 0 ? writer_hz : 1.0;
+        SensorManager mgr(std::make_unique<SyntheticSensorSource>(cfg));
+        mgr.initialize();
+
+        const uint64_t before = mgr.samples_received();
+        volatile float sink = 0.0f;
+        uint64_t reads = 0;
+        auto t0 = Clock::now();
+        auto deadline = t0 + std::chrono::duration<double>(rep.seconds(1.0));
+        while (Clock::now() < deadline) {
+            for (int i = 0; i < 1000; ++i) sink = sink + mgr.read_sensors().temperature;
+            reads += 1000;
+        }
+        double secs = elapsed_s(t0);
+        uint64_t writes = mgr.samples_received() - before;
+        mgr.shutdown();
+
+        rep.add("sensor_manager.read_sensors",
+                {{"writer_hz", writer_hz}, {"ns_per_read", secs * 1e9 / reads},
+                 {"writes_per_s", writes / secs}});
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Tmp102Sensor decode throughput against an in-memory register file.
+
+class FakeBusTmp102 : public Tmp102Sensor {
+public:
+    bool begin() override { return true; }
+protected:
+    bool readRegister(uint8_t, uint8_t* out, size_t n) override {
+        // Walk the full 12-bit range so sign extension is exercised.
+        uint16_t reg = static_cast<uint16_t>((next_++ & 0x0FFF) << 4);
+        out[0] = static_cast<uint8_t>(reg >> 8);
+        if (n > 1) out[1] = static_cast<uint8_t>(reg & 0xFF);
+        return true;
+    }
+private:
+    uint32_t next_ = 0;
+};
+
+void bench_tmp102(Reporter& rep) {
+    FakeBusTmp102 sensor;
+    volatile float sink = 0.0f;
+    uint64_t n = 0;
+    auto t0 = Clock::now();
+    auto deadline = t0 + std::chrono::duration<double>(rep.seconds(0.5));
+    while (Clock::now() < deadline) {
+        for (int i = 0; i < 4096; ++i) {
+            auto c = sensor.readCelsius();
+            if (c) sink = sink + *c;
+        }
+        n += 4096;
+    }
+    double secs = elapsed_s(t0);
+    rep.add("tmp102.read_celsius_fake_bus",
+            {{"reads_per_s", n / secs}, {"ns_per_read", secs * 1e9 / n}});
+
+    n = 0;
+    t0 = Clock::now();
+    deadline = t0 + std::chrono::duration<double>(rep.seconds(0.5));
+    while (Clock::now() < deadline) {
+        for (uint32_t i = 0; i < 65536; ++i) {
+            sink = sink + Tmp102Sensor::decodeCelsius(static_cast<uint8_t>(i >> 8),
+                                                      static_cast<uint8_t>(i));
+        }
+        n += 65536;
+    }
+    secs = elapsed_s(t0);
+    rep.add("tmp102.decode", {{"decodes_per_s", n / secs}, {"ns_per_decode", secs * 1e9 / n}});
+}
+
+// ---------------------------------------------------------------------------
+// DataLogger / NetworkManager per-sample cost (output formatting included).
+
+template <typename Fn>
+void bench_per_sample(Reporter& rep, const char* name, Fn&& fn) {
+    CoutSilencer quiet;
+    SensorData d;
+    d.temperature = 23.4f;
+    d.humidity = 51.2f;
+    uint64_t n = 0;
+    auto t0 = Clock::now();
+    auto deadline = t0 + std::chrono::duration<double>(rep.seconds(0.5));
+    while (Clock::now() < deadline) {
+        for (int i = 0; i < 1000; ++i) {
+            d.timestamp = n + i;
+            fn(d);
+        }
+        n += 1000;
+    }
+    double secs = elapsed_s(t0);
+    rep.add(name, {{"samples_per_s", n / secs}, {"ns_per_sample", secs * 1e9 / n}});
+}
+
+void bench_sinks(Reporter& rep) {
+    DataLogger logger("bench.db");
+    NetworkManager network;
+    bench_per_sample(rep, "data_logger.log_data", [&](const SensorData& d) { logger.log_data(d); });
+    bench_per_sample(rep, "network_manager.broadcast_data",
+                     [&](const SensorData& d) { network.broadcast_data(d); });
+
+    // Same sinks fed full SensorBatch blocks; cost reported per sample.
+    SensorBatchPool pool(1);
+    BatchHandle batch = pool.acquire();
+    SensorData d;
+    while (!batch->full()) batch->push(d);
+    uint32_t n = 0;
+    bench_per_sample(rep, "data_logger.log_batch", [&](const SensorData&) {
+        if (++n % SensorBatch::kCapacity == 0) logger.log_batch(*batch);
+    });
+    bench_per_sample(rep, "network_manager.broadcast_batch", [&](const SensorData&) {
+        if (++n % SensorBatch::kCapacity == 0) network.broadcast_batch(*batch);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// ReportFilter compression ratio and cost on a long synthetic series (slow
+// drift, noise, steps, motion/button edges). tests/report_filter_test.cpp
+// checks the reconstruction error on the same series.
+
+struct FilterCase {
+    const char* name;
+    ReportFilterConfig config;
+};
+
+void bench_report_filter(Reporter& rep) {
+    const size_t n = rep.quick() ? 100000 : 500000;
+    std::vector<SensorData> series(n);
+    std::minstd_rand rng(7);
+    std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+    std::uniform_int_distribution<int> edge(0, 9999);
+    int motion = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double t = i * 0.1;  // 10 Hz
+        SensorData& d = series[i];
+        d.timestamp = static_cast<uint64_t>(i) * 100000000ull;
+        d.temperature = static_cast<float>(22.0 + 3.0 * std::sin(t / 3000.0)) + noise(rng) +
+                        ((i / 20000) % 2 ? 1.5f : 0.0f);
+        d.humidity = static_cast<float>(50.0 + 8.0 * std::sin(t / 5000.0)) + noise(rng) * 5;
+        if (edge(rng) == 0) motion = !motion;
+        d.motion_detected = motion;
+        d.button_pressed = edge(rng) == 1;
+    }
+
+    ReportFilterConfig deadband;
+    deadband.mode = ReportFilterConfig::Mode::Deadband;
+    deadband.max_silence_ns = 600000000000ull;  // 10 min heartbeat
+    ReportFilterConfig sdt = deadband;
+    sdt.mode = ReportFilterConfig::Mode::SwingingDoor;
+    ReportFilterConfig sdt_rel = sdt;
+    sdt_rel.temperature = {0.0f, 0.005f};
+    sdt_rel.humidity = {0.0f, 0.01f};
+
+    for (const FilterCase& fc : {FilterCase{"deadband", deadband}, FilterCase{"swinging_door", sdt},
+                                 FilterCase{"swinging_door_relative", sdt_rel}}) {
+        SensorBatchPool pool(2);
+        BatchHandle in = pool.acquire();
+        BatchHandle out = pool.acquire();
+        ReportFilter filter(fc.config);
+        std::vector<SensorData> reported;
+        reported.reserve(n);
+
+        double filtering = 0.0;
+        auto drain = [&] {
+            for (uint32_t i = 0; i < out->count; ++i) reported.push_back(out->at(i));
+            out->clear();
+        };
+        for (size_t i = 0; i < n;) {
+            in->clear();
+            while (i < n && !in->full()) in->push(series[i++]);
+            uint32_t next = 0;
+            while (next < in->count) {
+                auto t0 = Clock::now();
+                next = filter.filter(*in, next, *out);
+                filtering += elapsed_s(t0);
+                drain();
+            }
+        }
+        filter.flush(*out);
+        drain();
+
+        rep.add(std::string("report_filter.") + fc.name,
+                {{"samples", double(n)}, {"reported", double(reported.size())},
+                 {"compression", double(n) / reported.size()},
+                 {"ns_per_sample", filtering * 1e9 / n}});
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TimeAligner cost on jittered periodic ramps plus motion edges delivered up
+// to 200 ms late (within the 250 ms lateness). tests/time_aligner_test.cpp
+// checks the fused records against ground truth on the same input.
+
+void bench_time_align(Reporter& rep) {
+    struct Input {
+        uint64_t arrival;
+        uint64_t timestamp;
+        AlignChannel channel;
+        float value;
+    };
+    const uint64_t ms = 1000000ull;
+    const uint64_t span = (rep.quick() ? 120 : 600) * 1000 * ms;
+    auto temp_at = [](uint64_t t) { return 20.0 + 0.05 * (t / 1e9); };
+    auto hum_at = [](uint64_t t) { return 40.0 + 0.02 * (t / 1e9); };
+
+    std::minstd_rand rng(11);
+    std::uniform_int_distribution<uint64_t> jitter(0, 5 * ms);
+    std::uniform_int_distribution<uint64_t> delivery(0, 20 * ms);
+    std::uniform_int_distribution<uint64_t> irq_delay(0, 200 * ms);
+    std::uniform_int_distribution<uint64_t> edge_gap(100 * ms, 2000 * ms);
+
+    std::vector<Input> inputs;
+    for (uint64_t t = 0; t < span; t += 50 * ms) {
+        uint64_t ts = t + jitter(rng);
+        inputs.push_back({ts + delivery(rng), ts, AlignChannel::Temperature, float(temp_at(ts))});
+    }
+    for (uint64_t t = 0; t < span; t += 70 * ms) {
+        uint64_t ts = t + jitter(rng);
+        inputs.push_back({ts + delivery(rng), ts, AlignChannel::Humidity, float(hum_at(ts))});
+    }
+    std::vector<uint64_t> edges;
+    for (uint64_t t = edge_gap(rng); t < span; t += edge_gap(rng)) {
+        edges.push_back(t);
+        inputs.push_back({t + irq_delay(rng), t, AlignChannel::Motion, float(edges.size() % 2)});
+    }
+    std::sort(inputs.begin(), inputs.end(),
+              [](const Input& a, const Input& b) { return a.arrival < b.arrival; });
+
+    TimeAlignerConfig config;
+    config.period_ns = 100 * ms;
+    config.lateness_ns = 250 * ms;
+    TimeAligner aligner(config);
+    SensorBatchPool pool(1);
+    BatchHandle out = pool.acquire();
+
+    uint64_t records = 0;
+    double aligning = 0.0;
+    for (const Input& in : inputs) {
+        auto t0 = Clock::now();
+        aligner.push(in.channel, in.timestamp, in.value);
+        records += aligner.drain(*out);
+        aligning += elapsed_s(t0);
+        out->clear();
+    }
+    while (uint32_t n = aligner.flush(*out)) {
+        records += n;
+        out->clear();
+    }
+
+    rep.add("time_align.fuse",
+            {{"observations", double(inputs.size())}, {"records", double(records)},
+             {"ns_per_observation", aligning * 1e9 / inputs.size()},
+             {"late", double(aligner.late())}});
+}
+
+// ---------------------------------------------------------------------------
+// Trace point cost with tracing off (the production default) and on.
+
+void bench_trace(Reporter& rep) {
+    for (bool on : {false, true}) {
+        trace::set_enabled(on);
+        trace::TraceWriter sink;  // drains buffers between rounds, untimed
+        if (on) sink.open("/dev/null");
+        uint64_t n = 0;
+        double recording = 0.0;
+        auto deadline = Clock::now() + std::chrono::duration<double>(rep.seconds(0.5));
+        while (Clock::now() < deadline) {
+            auto t0 = Clock::now();
+            for (uint64_t i = 0; i < 1000; ++i) {
+                TRACE_SCOPE("bench.scope", n + i);
+            }
+            recording += elapsed_s(t0);
+            n += 1000;
+            if (on) sink.flush();
+        }
+        trace::set_enabled(false);
+        rep.add("trace.scope", {{"enabled", on ? 1.0 : 0.0}, {"ns_per_scope", recording * 1e9 / n}});
+    }
+
+    // Short-lived recording threads: each buffer must be exported and freed
+    // by the writer once its thread has gone
+    trace::TraceWriter sink;
+    sink.open("/dev/null");
+    sink.flush();
+    const size_t before = trace::thread_buffers();
+    trace::set_enabled(true);
+    constexpr int kThreads = 64;
+    for (int t = 0; t < kThreads; ++t) {
+        std::thread([t] { TRACE_SCOPE("bench.thread", t); }).join();
+    }
+    trace::set_enabled(false);
+    size_t exported = sink.flush();
+    size_t after = trace::thread_buffers();
+    rep.add("trace.retire", {{"threads", kThreads}, {"events", static_cast<double>(exported)},
+                             {"buffers_left", static_cast<double>(after) - before}});
+    if (exported != 2 * kThreads) rep.fail("trace.retire: events lost from exited threads");
+    if (after > before) rep.fail("trace.retire: exited threads' buffers not freed");
+}
+
+// ---------------------------------------------------------------------------
+// Reactor: eventfd ping-pong between two coroutines on one thread (vs. two
+// blocking threads) and timer wakeup overshoot, per backend. Correctness
+// checks for the same backends are in tests/reactor_test.cpp.
+
+AsyncTask<> ping(Reactor& r, int out_fd, int in_fd, const bool& stop, uint64_t& trips) {
+    uint64_t v = 1;
+    while (!stop) {
+        co_await r.write(out_fd, &v, sizeof(v));
+        co_await r.read(in_fd, &v, sizeof(v));
+        ++trips;
+    }
+    v = 2;
+    co_await r.write(out_fd, &v, sizeof(v));  // release pong
+}
+
+// Exactly one write is outstanding at a time, so the value read is the one
+// ping wrote: 2 ends the exchange.
+AsyncTask<> pong(Reactor& r, int in_fd, int out_fd) {
+    uint64_t v;
+    while (true) {
+        co_await r.read(in_fd, &v, sizeof(v));
+        if (v == 2) break;
+        co_await r.write(out_fd, &v, sizeof(v));
+    }
+}
+
+AsyncTask<> stopper(Reactor& r, double seconds, bool& stop) {
+    co_await r.sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(seconds)));
+    stop = true;
+}
+
+AsyncTask<> sleeper(Reactor& r, int rounds, LatencyHistogram& overshoot) {
+    for (int i = 0; i < rounds; ++i) {
+        uint64_t due = monotonic_ns() + 1000000ull;
+        co_await r.sleep_until(due);
+        uint64_t now = monotonic_ns();
+        overshoot.record(now > due ? now - due : 0);
+    }
+}
+
+void bench_reactor(Reporter& rep) {
+    double seconds = rep.seconds(0.5);
+    for (bool uring : {true, false}) {
+        Reactor r(uring);
+        if (uring && r.backend() != Reactor::Backend::IoUring) {
+            std::cerr << "  io_uring unavailable, skipping" << std::endl;
+            continue;
+        }
+        std::string name = std::string("reactor.") + r.backend_name();
+
+        int a = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        int b = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        bool stop = false;
+        uint64_t trips = 0;
+        r.spawn(pong(r, a, b));
+        r.spawn(ping(r, a, b, stop, trips));
+        r.spawn(stopper(r, seconds, stop));
+        auto t0 = Clock::now();
+        r.run();
+        double t = elapsed_s(t0);
+        rep.add(name + ".pingpong", {{"round_trips", double(trips)}, {"ns_per_round_trip", t * 1e9 / trips}});
+
+        LatencyHistogram overshoot;
+        int rounds = rep.quick() ? 50 : 250;
+        r.spawn(sleeper(r, rounds, overshoot));
+        r.run();
+        rep.add(name + ".sleep_1ms", {{"p50_overshoot_ns", double(overshoot.percentile(50))},
+                                      {"p99_overshoot_ns", double(overshoot.percentile(99))},
+                                      {"max_overshoot_ns", double(overshoot.max())}});
+
+        ::close(a);
+        ::close(b);
+    }
+
+    // Baseline: the same ping-pong as two blocking threads
+    int a = ::eventfd(0, EFD_CLOEXEC);
+    int b = ::eventfd(0, EFD_CLOEXEC);
+    uint64_t trips = 0;
+    std::thread pong_thread([&] {
+        uint64_t v;
+        while (::read(a, &v, sizeof(v)) == sizeof(v) && v != 2) {
+            if (::write(b, &v, sizeof(v)) != sizeof(v)) break;
+        }
+    });
+    auto t0 = Clock::now();
+    auto deadline = t0 + std::chrono::duration<double>(seconds);
+    uint64_t v = 1;
+    while (Clock::now() < deadline) {
+        if (::write(a, &v, sizeof(v)) != sizeof(v) || ::read(b, &v, sizeof(v)) != sizeof(v)) break;
+        ++trips;
+    }
+    double t = elapsed_s(t0);
+    v = 2;
+    if (::write(a, &v, sizeof(v)) != sizeof(v)) rep.fail("reactor.threads: cannot stop pong");
+    pong_thread.join();
+    ::close(a);
+    ::close(b);
+    rep.add("reactor.threads.pingpong", {{"round_trips", double(trips)}, {"ns_per_round_trip", t * 1e9 / trips}});
+}
+
+// ---------------------------------------------------------------------------
+// Signal-driven stress for the cover<>/EventCapture capture path. SIGUSR1
+// handlers act as ISRs: they interrupt the consumer mid-pop, interrupt task
+// producers mid-push, and run concurrently on other threads. Every event id is
+// accounted for (popped or counted as dropped) and every payload is checked.
+
+namespace sigstress {
+
+using StressCover = cover<posix::signal_cover<SIGUSR1>>;
+
+EventCapture<EdgeEvent, 1024> queue;
+EventSnapshot<EdgeEvent> last_edge;
+StressCover cov;
+std::atomic<uint32_t> next_id{0};
+volatile uint64_t pair[2];  // written by the handler, read under protect_lock
+thread_local bool is_consumer = false;
+
+// Busy-wait that the optimizer can't remove
+void spin(int iterations) {
+    for (int i = 0; i < iterations; ++i) asm volatile("" ::: "memory");
+}
+
+uint16_t check_of(uint32_t id) { return static_cast<uint16_t>((id * 2654435761u) >> 16); }
+
+EdgeEvent make_event() {
+    uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return {uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec), id,
+            static_cast<uint16_t>(id), check_of(id)};
+}
+
+void handler(int) {
+    EdgeEvent e = make_event();
+    queue.push(e);
+    if (is_consumer) {
+        // Only the consumer thread's handler writes state guarded by the cover
+        sync_lock<StressCover> lk(cov);
+        pair[0] = e.seq;
+        pair[1] = e.seq;
+        last_edge.store(e);
+    }
+}
+
+}
+
+void bench_signal_capture(Reporter& rep) {
+    using namespace sigstress;
+
+    struct sigaction sa{}, old{};
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, &old);
+
+    is_consumer = true;
+    next_id = 0;
+    const size_t kMaxIds = size_t(1) << 26;
+    std::vector<bool> seen(kMaxIds);
+    uint64_t popped = 0, torn = 0, duplicate = 0, pair_torn = 0, snapshot_torn = 0;
+
+    auto consume = [&] {
+        EdgeEvent e;
+        while (queue.pop(e)) {
+            ++popped;
+            if (e.line != static_cast<uint16_t>(e.seq) || e.level != check_of(e.seq)) {
+                ++torn;
+            } else if (e.seq < kMaxIds) {
+                if (seen[e.seq]) ++duplicate;
+                seen[e.seq] = true;
+            }
+        }
+    };
+
+    std::atomic<bool> stop{false}, stop_senders{false};
+    std::vector<pthread_t> targets{pthread_self()};
+    std::vector<std::thread> producers, senders;
+    std::mutex targets_m;
+    for (int i = 0; i < 2; ++i) {
+        producers.emplace_back([&] {
+            {
+                std::lock_guard<std::mutex> lk(targets_m);
+                targets.push_back(pthread_self());
+            }
+            while (!stop) {
+                queue.push(make_event());
+                spin(2000);
+            }
+        });
+    }
+    while (true) {
+        std::lock_guard<std::mutex> lk(targets_m);
+        if (targets.size() == 3) break;
+    }
+    for (int i = 0; i < 2; ++i) {
+        senders.emplace_back([&, i] {
+            size_t k = i;
+            while (!stop_senders) pthread_kill(targets[k++ % targets.size()], SIGUSR1);
+        });
+    }
+
+    auto t0 = Clock::now();
+    auto deadline = t0 + std::chrono::duration<double>(rep.seconds(2.0));
+    while (Clock::now() < deadline) {
+        consume();
+        uint64_t a, b;
+        {
+            protect_lock<StressCover> lk(cov);
+            a = pair[0];
+            spin(50);
+            b = pair[1];
+        }
+        if (a != b) ++pair_torn;
+        EdgeEvent e;
+        if (last_edge.load(e) && e.level != check_of(e.seq)) ++snapshot_torn;
+    }
+
+    // Senders first: a target must not exit while it can still be signalled
+    stop_senders = true;
+    for (auto& t : senders) t.join();
+    stop = true;
+    for (auto& t : producers) t.join();
+
+    // No handler can run on this thread after this point, so the final drain
+    // sees every event that was ever pushed.
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, &saved);
+    consume();
+    double secs = elapsed_s(t0);
+
+    uint64_t ids = next_id.load();
+    uint64_t lost = ids - std::min<uint64_t>(ids, popped + queue.dropped());
+
+    sigaction(SIGUSR1, &old, nullptr);
+    pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+    is_consumer = false;
+
+    rep.add("signal_capture.stress",
+            {{"events", double(ids)}, {"events_per_s", ids / secs},
+             {"popped", double(popped)}, {"dropped_full", double(queue.dropped())},
+             {"lost", double(lost)}, {"torn", double(torn + pair_torn + snapshot_torn)},
+             {"duplicate", double(duplicate)}});
+    if (ids >= kMaxIds) rep.fail("signal_capture: id space exceeded, shorten the run");
+    if (lost || duplicate) rep.fail("signal_capture: lost or duplicated events");
+    if (torn || pair_torn || snapshot_torn) rep.fail("signal_capture: torn events");
+}
+
+// ---------------------------------------------------------------------------
+// Shared-memory channel: publish cost with no readers, polling readers and a
+// futex-blocked reader, then wake latency for a blocked reader at a paced
+// publish rate. tests/shm_test.cpp checks tearing, overruns and epochs.
+
+struct ShmReaderResult {
+    uint64_t read = 0;
+    uint64_t overruns = 0;
+};
+
+void fill_shm_batch(SensorBatch& b, uint64_t first_seq, uint32_t n, uint64_t ts) {
+    b.first_seq = first_seq;
+    b.count = n;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t seq = first_seq + i;
+        b.timestamp[i] = ts;
+        b.temperature[i] = static_cast<float>(seq % 100000);
+        b.humidity[i] = static_cast<float>((seq * 7) % 100000);
+        b.flags[i] = static_cast<uint8_t>(seq & 3);
+    }
+}
+
+void shm_reader(const std::string& name, bool blocking, const std::atomic<bool>& stop,
+                ShmReaderResult& out) {
+    ShmReader reader;
+    if (reader.open(name) != 0) return;
+    pirtos_shm_record recs[64];
+    while (true) {
+        bool done = stop.load(std::memory_order_acquire);
+        if (blocking) reader.wait(10);
+        int n = reader.read(recs, 64);
+        out.read += n > 0 ? n : 0;
+        if (done && n <= 0) break;
+    }
+    out.overruns = reader.overruns();
+}
+
+void bench_shm(Reporter& rep) {
+    const std::string name = "/pirtos_bench_" + std::to_string(::getpid());
+    double seconds = rep.seconds(0.5);
+    SensorBatch batch;
+
+    for (int readers : {0, 2}) {
+        ShmPublisher pub;
+        if (!pub.open(name, 4096)) {
+            rep.fail("shm: cannot create ring");
+            return;
+        }
+        std::atomic<bool> stop{false};
+        std::vector<ShmReaderResult> results(readers + 1);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; ++i) {
+            threads.emplace_back(shm_reader, name, false, std::cref(stop), std::ref(results[i]));
+        }
+        if (readers) {
+            threads.emplace_back(shm_reader, name, true, std::cref(stop), std::ref(results[readers]));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        uint64_t seq = 0;
+        auto t0 = Clock::now();
+        auto deadline = t0 + std::chrono::duration<double>(seconds);
+        while (Clock::now() < deadline) {
+            for (int i = 0; i < 16; ++i) {
+                fill_shm_batch(batch, seq, 64, seq);
+                pub.publish(batch);
+                seq += 64;
+            }
+        }
+        double secs = elapsed_s(t0);
+        stop = true;
+        for (auto& t : threads) t.join();
+
+        uint64_t read = 0, overruns = 0;
+        for (int i = 0; i < (readers ? readers + 1 : 0); ++i) {
+            read += results[i].read;
+            overruns += results[i].overruns;
+        }
+        rep.add("shm.publish", {{"readers", double(readers ? readers + 1 : 0)},
+                                {"records_per_s", seq / secs},
+                                {"ns_per_record", secs * 1e9 / seq},
+                                {"read", double(read)}, {"overruns", double(overruns)}});
+        ::shm_unlink(name.c_str());
+    }
+
+    // Wake latency: one record every 200us, blocked reader stamps arrival
+    {
+        ShmPublisher pub;
+        if (!pub.open(name, 4096)) return;
+        ShmReader reader;
+        reader.open(name);
+        LatencyHistogram wake;
+        std::atomic<bool> stop{false};
+        std::thread t([&] {
+            pirtos_shm_record recs[64];
+            while (!stop) {
+                if (!reader.wait(10)) continue;
+                int n = reader.read(recs, 64);
+                uint64_t now = monotonic_ns();
+                if (n > 0) wake.record(now - recs[n - 1].timestamp_ns);
+            }
+        });
+        uint64_t seq = 0;
+        auto deadline = Clock::now() + std::chrono::duration<double>(seconds);
+        while (Clock::now() < deadline) {
+            fill_shm_batch(batch, seq, 1, monotonic_ns());
+            pub.publish(batch);
+            ++seq;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        stop = true;
+        t.join();
+        rep.add("shm.wake", {{"published", double(seq)}, {"wakes", double(wake.count())},
+                             {"p50_us", wake.percentile(50) / 1e3},
+                             {"p99_us", wake.percentile(99) / 1e3},
+                             {"max_us", wake.max() / 1e3}});
+        ::shm_unlink(name.c_str());
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Fixed point: batch column conversion at the float edge, vector vs scalar
+// (must agree bit for bit), and milli round trips over the sensor range.
+
+void bench_fixed_point(Reporter& rep) {
+    constexpr size_t kColumn = SensorBatch::kCapacity;
+    std::vector<int32_t> milli(kColumn * 64);
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int32_t> value(-40000, 125000);
+    for (int32_t& m : milli) m = value(rng);
+    std::vector<float> vec(milli.size()), ref(milli.size());
+
+    using Convert = void (*)(const int32_t*, float*, size_t);
+    for (auto [name, fn] : {std::pair<const char*, Convert>{"vector", fixed::milli_to_float},
+                            std::pair<const char*, Convert>{"scalar", fixed::milli_to_float_scalar}}) {
+        std::vector<float>& out = fn == fixed::milli_to_float ? vec : ref;
+        uint64_t n = 0;
+        auto t0 = Clock::now();
+        auto deadline = t0 + std::chrono::duration<double>(rep.seconds(0.3));
+        while (Clock::now() < deadline) {
+            // One call per batch-sized column, as SensorManager does
+            for (size_t off = 0; off < milli.size(); off += kColumn) {
+                fn(milli.data() + off, out.data() + off, kColumn);
+            }
+            asm volatile("" : : "r"(out.data()) : "memory");
+            n += milli.size();
+        }
+        double secs = elapsed_s(t0);
+        rep.add(std::string("fixed_point.milli_to_float.") + name,
+                {{"samples_per_s", n / secs}, {"ns_per_sample", secs * 1e9 / n},
+                 {"ns_per_batch", secs * 1e9 / n * kColumn}});
+    }
+
+    uint64_t mismatched = 0;
+    for (size_t i = 0; i < milli.size(); ++i) {
+        if (std::memcmp(&vec[i], &ref[i], sizeof(float)) != 0) ++mismatched;
+    }
+    uint64_t round_trip = 0;
+    for (int32_t m = -40000; m <= 125000; ++m) {
+        if (fixed::to_milli(fixed::from_milli(m)) != m) ++round_trip;
+    }
+    rep.add("fixed_point.check", {{"vector_mismatches", double(mismatched)},
+                                  {"round_trip_errors", double(round_trip)}});
+    if (mismatched) rep.fail("fixed_point: vector and scalar conversion differ");
+    if (round_trip) rep.fail("fixed_point: milli value does not survive float and back");
+}
+
+struct Suite {
+    const char* name;
+    std::function<void(Reporter&)> run;
+};
+
+}
+
+int main(int argc, char** argv) {
+    std::string json_path, filter;
+    bool quick = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) json_path = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--quick") quick = true;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--json FILE] [--filter NAME] [--quick]" << std::endl;
+            return 2;
+        }
+    }
+
+    const std::vector<Suite> suites = {
+        {"ringbuffer", bench_ringbuffer},
+        {"scheduler", bench_scheduler},
+        {"sensor_manager", bench_read_sensors},
+        {"tmp102", bench_tmp102},
+        {"sinks", bench_sinks},
+        {"fixed_point", bench_fixed_point},
+        {"report_filter", bench_report_filter},
+        {"time_align", bench_time_align},
+        {"trace", bench_trace},
+        {"reactor", bench_reactor},
+        {"signal_capture", bench_signal_capture},
+        {"shm", bench_shm},
+    };
+
+    Reporter rep(quick);
+    for (const Suite& s : suites) {
+        if (!filter.empty() && std::string(s.name).find(filter) == std::string::npos) continue;
+        std::cerr << "[bench] " << s.name << std::endl;
+        s.run(rep);
+    }
+
+    if (json_path.empty()) {
+        rep.write_json(std::cout);
+    } else {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "cannot write " << json_path << std::endl;
+            return 1;
+        }
+        rep.write_json(out);
+    }
+    return rep.failed() ? 1 : 0;
+}
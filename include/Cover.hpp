@@ -0,0 +1,43 @@
+#pragma once
+// Compile-time synchronization policy between "ISR" context and task context.
+//
+// A backend (System) supplies four operations:
+//   protect()/unprotect()  task side: no ISR may run on this core/thread inside
+//   sync()/unsync()        ISR side: order accesses against the interrupted task
+//
+// Backends: armv7_m::cover (CoverArmv7m.hpp) for the MCU build, and
+// posix::signal_cover<...> (CoverPosix.hpp) where async-signal handlers play
+// the ISR role on Linux.
+
+// Interface to our cover class.
+template <typename System>
+class cover : System {
+public:
+  // Called by low priority task to start/end a critical section.
+  void protect() { System::protect(); }
+  void unprotect() { System::unprotect(); }
+
+  // Called by a high priority task to start/end a synchronization region.
+  void sync() { System::sync(); }
+  void unsync() { System::unsync(); }
+};
+
+template <typename Cover>
+class protect_lock {
+  Cover& m_c;
+public:
+  explicit protect_lock(Cover& c) : m_c(c) { c.protect(); }
+  ~protect_lock() { m_c.unprotect(); }
+  protect_lock(const protect_lock&) = delete;
+  protect_lock& operator=(const protect_lock&) = delete;
+};
+
+template <typename Cover>
+class sync_lock {
+  Cover& m_c;
+public:
+  explicit sync_lock(Cover& c) : m_c(c) { c.sync(); }
+  ~sync_lock() { m_c.unsync(); }
+  sync_lock(const sync_lock&) = delete;
+  sync_lock& operator=(const sync_lock&) = delete;
+};
@@ -0,0 +1,25 @@
+#pragma once
+// ARMv7-M (Cortex-M3/M4/M7) backend for cover<>: the task side masks IRQs
+// with PRIMASK, so only the interrupted core needs ordering.
+#include <atomic>
+
+#if !defined(__ARM_ARCH_7M__) && !defined(__ARM_ARCH_7EM__)
+#error "CoverArmv7m.hpp is for ARMv7-M targets; use CoverPosix.hpp on Linux"
+#endif
+
+namespace armv7_m {
+class cover {
+public:
+  void protect() {
+    __asm volatile("cpsid i" ::: "memory");
+    sync();
+  }
+  void unprotect() {
+    unsync();
+    __asm volatile("cpsie i" ::: "memory");
+  }
+
+  void sync() { std::atomic_thread_fence(std::memory_order_acquire); }
+  void unsync() { std::atomic_thread_fence(std::memory_order_release); }
+};
+}
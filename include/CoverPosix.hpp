@@ -0,0 +1,49 @@
+#pragma once
+// Linux userspace backend for cover<>: async-signal handlers are the "ISR".
+//
+// protect() blocks Signals on the calling thread, so a handler delivered to
+// that thread cannot run inside the critical section. Route the capture
+// signals to the thread that protects (pthread_kill, timer_create with
+// SIGEV_THREAD_ID, F_SETOWN_EX) or block them everywhere else; a handler on
+// another thread runs truly in parallel and must only touch lock-free state
+// such as EventCapture. Handlers never take locks.
+#include <atomic>
+#include <csignal>
+#include <pthread.h>
+
+namespace posix {
+template <int... Signals>
+class signal_cover {
+public:
+  void protect() {
+    State& st = state();
+    if (st.depth++ == 0) {
+      sigset_t set;
+      sigemptyset(&set);
+      (sigaddset(&set, Signals), ...);
+      pthread_sigmask(SIG_BLOCK, &set, &st.saved);
+    }
+    std::atomic_signal_fence(std::memory_order_acquire);
+  }
+  void unprotect() {
+    std::atomic_signal_fence(std::memory_order_release);
+    State& st = state();
+    if (--st.depth == 0) pthread_sigmask(SIG_SETMASK, &st.saved, nullptr);
+  }
+
+  // The handler runs on the thread it interrupted; a compiler fence is enough.
+  void sync() { std::atomic_signal_fence(std::memory_order_acquire); }
+  void unsync() { std::atomic_signal_fence(std::memory_order_release); }
+
+private:
+  struct State {
+    int depth;
+    sigset_t saved;
+  };
+  // Per thread, so nested protect() restores the outermost mask only.
+  static State& state() {
+    static thread_local State st{};
+    return st;
+  }
+};
+}
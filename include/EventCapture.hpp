@@ -0,0 +1,129 @@
+#pragma once
+// Lock-free capture structures for high-rate edge events raised in "ISR"
+// context (signal handlers on Linux, IRQs on Cortex-M). Producers never block,
+// never allocate and never take locks, so they are async-signal-safe and may
+// interrupt each other, including a producer on the same thread.
+//
+// None of this goes through cover<>: a cover section only excludes handlers
+// on the protecting core/thread, while these producers may also run in
+// parallel on other threads or cores. Use cover<> (Cover.hpp) for plain state
+// shared between a handler and the task it interrupts.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Bounded multi-producer / single-consumer queue (per-slot sequence numbers).
+// push() fails and counts a drop when the queue is full, or when the next slot
+// is still being written by a producer it interrupted.
+template <typename T, size_t N>
+class EventCapture {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "events are copied from handlers");
+  static_assert(std::atomic<size_t>::is_always_lock_free &&
+                std::atomic<uint32_t>::is_always_lock_free, "needs lock-free atomics");
+
+public:
+  EventCapture() {
+    for (size_t i = 0; i < N; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  EventCapture(const EventCapture&) = delete;
+  EventCapture& operator=(const EventCapture&) = delete;
+
+  // Producer side; safe in signal handlers and from any thread.
+  bool push(const T& v) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& s = slots_[pos & (N - 1)];
+      size_t seq = s.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          s.value = v;
+          s.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Consumer side; one consumer at a time, task context only.
+  bool pop(T& out) {
+    Slot& s = slots_[tail_ & (N - 1)];
+    if (s.seq.load(std::memory_order_acquire) != tail_ + 1) return false;
+    out = s.value;
+    s.seq.store(tail_ + N, std::memory_order_release);
+    ++tail_;
+    return true;
+  }
+
+  // Wraps at 2^32; 64-bit atomics are not lock-free on ARMv7-M.
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  Slot slots_[N];
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) size_t tail_ = 0;
+  std::atomic<uint32_t> dropped_{0};
+};
+
+// Latest-value cell (seqlock) for state such as "last PIR edge". One writer
+// context (a handler that cannot nest with itself), any number of readers.
+// Readers retry instead of blocking the writer, so never load() from a handler
+// that can interrupt store(). The payload is kept in atomic words so a torn
+// read is detected, never undefined behaviour.
+template <typename T>
+class EventSnapshot {
+  static_assert(std::is_trivially_copyable<T>::value, "snapshots are copied word-wise");
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+public:
+  void store(const T& v) {
+    uint32_t words[kWords]{};
+    std::memcpy(words, &v, sizeof(T));
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) data_[i].store(words[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Returns false if no value has been stored yet.
+  bool load(T& out) const {
+    uint32_t words[kWords];
+    uint32_t before, after;
+    do {
+      before = seq_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < kWords; ++i) words[i] = data_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    if (before == 0) return false;
+    std::memcpy(&out, words, sizeof(T));
+    return true;
+  }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> data_[kWords]{};
+};
+
+// Typical payload for GPIO edges captured in a handler.
+struct EdgeEvent {
+  uint64_t timestamp_ns;
+  uint32_t seq;
+  uint16_t line;   // GPIO line / signal number
+  uint16_t level;  // level after the edge
+};
@@ -2,6 +2,7 @@
 #include <cstddef>
 #include <mutex>
 #include <optional>
+#include <utility>
 #include <vector>
 
 template <typename T>
@@ -19,11 +20,16 @@ public:
   std::optional<T> pop() {
     std::lock_guard<std::mutex> lk(m_);
     if (count_ == 0) return std::nullopt;
-    T v = *buf_[(tail_++) % buf_.size()];
+    auto& slot = buf_[(tail_++) % buf_.size()];
+    T v = std::move(*slot);
+    slot.reset();  // don't keep the popped value alive in the buffer
     --count_;
     return v;
   }
-  size_t size() const { return count_; }
+  size_t size() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return count_;
+  }
   size_t capacity() const { return buf_.size(); }
 
 private:
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <optional>
@@ -7,9 +8,17 @@ class Tmp102Sensor {
 public:
   // bus like "/dev/i2c-1", default TMP102 addr 0x48
   Tmp102Sensor(std::string bus = "/dev/i2c-1", uint8_t addr = 0x48);
-  bool begin();
+  virtual ~Tmp102Sensor();
+  virtual bool begin();
   std::optional<float> readCelsius();
 
+  // 12-bit two's complement temperature register -> degrees C
+  static float decodeCelsius(uint8_t msb, uint8_t lsb);
+
+protected:
+  // Pointer write + n-byte read; overridden to run against a fake bus
+  virtual bool readRegister(uint8_t reg, uint8_t* out, size_t n);
+
 private:
   std::string bus_;
   uint8_t addr_;
@@ -1,39 +1,16 @@
-//still working on it 
+// cover<> example: a periodic "ISR" bumps a counter and records edges while the
+// task side reads them. Builds for Cortex-M (SysTick) or Linux (SIGALRM).
 
-// Interface to our cover class.
-template<typename System>
-class cover : System
-{
-public:
-    // Called by low priority task to start/end a critical section.
-    void protect() { System::protect(); }
-    void unprotect() { System::unprotect(); }
-
-    // Called by a high priority task to start/end a synchronization region.
-    void sync() { System::sync(); }
-    void unsync() { System::unsync(); }
-};
-
-
-
-template<typename Cover>
-class protect_lock {
-    Cover& m_c;
-public:
-    protect_lock(Cover& c) : m_c(c) { c.protect(); }
-    ~protect_lock() { m_c.unprotect(); }
-};
-
-template<typename Cover>
-class sync_lock {
-    Cover& m_c;
-public:
-    sync_lock(Cover& c) : m_c(c) { c.sync(); }
-    ~sync_lock() { m_c.unsync(); }
-};
+#include "Cover.hpp"
+#include "EventCapture.hpp"
 
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
 
 //the below is viable on an ARM Cortex-M4 microcontroller
+#include "CoverArmv7m.hpp"
+
+extern void setupSysTick();
+extern void setLed(bool on);
 
 using Cover = cover<armv7_m::cover>;
 static Cover cov;
@@ -51,24 +28,68 @@ int main()
     while(1) {
         bool odd;
         {
-            protect_lock<Cover> lk;
+            protect_lock<Cover> lk(cov);
             odd = (count & 1) != 0;
         }
         setLed(odd);
     }
 }
 
+#else
+
+#include "CoverPosix.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <sys/time.h>
+
+using Cover = cover<posix::signal_cover<SIGALRM>>;
+static Cover cov;
+static unsigned count;
+static EventCapture<EdgeEvent, 256> edges;
+
+static void alarm_handler(int)
+{
+    sync_lock<Cover> lk(cov);
+    count++;
+
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    edges.push({uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec),
+                count, SIGALRM, uint16_t(count & 1)});
+}
 
-// ARMV7-M implementation of cover
-namespace armv7-m {
-class cover
+int main()
 {
-public:
-    void protect() { __disable_irq(); sync(); }
-    void unprotect() { unsync(); __enable_irq(); }
+    struct sigaction sa{};
+    sa.sa_handler = alarm_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGALRM, &sa, nullptr);
+
+    itimerval tick{{0, 1000}, {0, 1000}};  // 1 kHz
+    setitimer(ITIMER_REAL, &tick, nullptr);
 
-    void sync() { std::atomic_thread_fence(std::memory_order::acquire); }
-    void unsync() { std::atomic_thread_fence(std::memory_order::release); }
-};
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < 10; ++i) {
+        next.tv_nsec += 100000000;
+        if (next.tv_nsec >= 1000000000) { next.tv_sec++; next.tv_nsec -= 1000000000; }
+        // SIGALRM interrupts the sleep; keep sleeping until the deadline
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+        unsigned snapshot;
+        {
+            protect_lock<Cover> lk(cov);
+            snapshot = count;
+        }
+        EdgeEvent e;
+        unsigned drained = 0;
+        while (edges.pop(e)) ++drained;
+        std::printf("count=%u led=%s drained=%u dropped=%llu\n", snapshot,
+                    (snapshot & 1) ? "on" : "off", drained,
+                    static_cast<unsigned long long>(edges.dropped()));
+    }
+    return 0;
 }
 
+#endif
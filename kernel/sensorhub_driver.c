@@ -9,8 +9,13 @@
 #include <linux/i2c.h>
 #include <linux/delay.h>
 #include <linux/wait.h>
+#include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/random.h>
+#include <linux/spinlock.h>
+#include <linux/ktime.h>
+
+#include "sensorhub_driver.h"
 
 #define DEVICE_NAME "sensorhub"
 #define CLASS_NAME "pirtos"
@@ -27,19 +32,21 @@ static struct class* sensorhub_class = NULL;
 static struct device* sensorhub_device = NULL;
 static struct cdev sensorhub_cdev;
 
-// Sensor data structure (must match userspace SensorManager view)
-struct sensor_data {
-    float temperature;
-    float humidity;
-    int motion_detected;
-    int button_pressed;
-    unsigned long timestamp;
-};
-
-static struct sensor_data current_data;
+// Latest readings; IRQ and timer paths update it under sample_lock. All
+// values are integers (no FPU use in interrupt or timer context).
+static struct sensorhub_sample current_sample;
+static DEFINE_SPINLOCK(sample_lock);
 static DECLARE_WAIT_QUEUE_HEAD(data_wait_queue);
 static int data_ready;
 
+// Stamps the record and marks it readable; called with sample_lock held
+static void sample_updated(void) {
+    current_sample.timestamp_ns = ktime_get_ns();
+    current_sample.seq++;
+    current_sample.version = SENSORHUB_ABI_VERSION;
+    data_ready = 1;
+}
+
 static int pir_irq_number;
 static int button_irq_number;
 
@@ -58,25 +65,50 @@ static int device_release(struct inode *inodep, struct file *filep) {
 }
 
 static ssize_t device_read(struct file *filep, char __user *buffer, size_t len, loff_t *offset) {
+    struct sensorhub_sample sample;
+    unsigned long flags;
     int ret;
 
+    if (len < sizeof(sample))
+        return -EINVAL;
+
+    // Nonblocking readers (the userspace reactor) poll() first
+    if (!data_ready && (filep->f_flags & O_NONBLOCK))
+        return -EAGAIN;
+
     // Wait for data to be ready
     ret = wait_event_interruptible(data_wait_queue, data_ready);
     if (ret)
         return ret;
 
-    if (copy_to_user(buffer, &current_data, sizeof(struct sensor_data)))
+    // Snapshot under the lock so an IRQ cannot tear the record
+    spin_lock_irqsave(&sample_lock, flags);
+    sample = current_sample;
+    data_ready = 0;
+    spin_unlock_irqrestore(&sample_lock, flags);
+
+    if (copy_to_user(buffer, &sample, sizeof(sample)))
         return -EFAULT;
 
-    data_ready = 0;
-    return sizeof(struct sensor_data);
+    return sizeof(sample);
+}
+
+static __poll_t device_poll(struct file *filep, poll_table *wait) {
+    poll_wait(filep, &data_wait_queue, wait);
+    return data_ready ? (EPOLLIN | EPOLLRDNORM) : 0;
 }
 
 static long device_ioctl(struct file *file, unsigned int cmd, unsigned long arg) {
+    int version = SENSORHUB_ABI_VERSION;
+
     switch (cmd) {
-    case 0x01: // reset data_ready
+    case SENSORHUB_RESET_DATA:
         data_ready = 0;
         break;
+    case SENSORHUB_GET_ABI_VERSION:
+        if (copy_to_user((int __user *)arg, &version, sizeof(version)))
+            return -EFAULT;
+        break;
     default:
         return -EINVAL;
     }
@@ -86,6 +118,7 @@ static long device_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 static struct file_operations fops = {
     .open = device_open,
     .read = device_read,
+    .poll = device_poll,
     .release = device_release,
     .unlocked_ioctl = device_ioctl,
 };
@@ -93,10 +126,15 @@ static struct file_operations fops = {
 // Interrupt handler for PIR sensor
 static irqreturn_t pir_interrupt_handler(int irq, void *dev_id) {
     int motion_value = gpio_get_value(GPIO_PIR);
+    unsigned long flags;
 
-    current_data.motion_detected = motion_value;
-    current_data.timestamp = jiffies;
-    data_ready = 1;
+    spin_lock_irqsave(&sample_lock, flags);
+    if (motion_value)
+        current_sample.flags |= SENSORHUB_FLAG_MOTION;
+    else
+        current_sample.flags &= ~SENSORHUB_FLAG_MOTION;
+    sample_updated();
+    spin_unlock_irqrestore(&sample_lock, flags);
 
     // Toggle LED on motion detection
     gpio_set_value(GPIO_LED, motion_value);
@@ -108,9 +146,12 @@ static irqreturn_t pir_interrupt_handler(int irq, void *dev_id) {
 
 // Button interrupt handler
 static irqreturn_t button_interrupt_handler(int irq, void *dev_id) {
-    current_data.button_pressed = 1;
-    current_data.timestamp = jiffies;
-    data_ready = 1;
+    unsigned long flags;
+
+    spin_lock_irqsave(&sample_lock, flags);
+    current_sample.flags |= SENSORHUB_FLAG_BUTTON;
+    sample_updated();
+    spin_unlock_irqrestore(&sample_lock, flags);
 
     wake_up_interruptible(&data_wait_queue);
     pr_info("PiRTOS: Button pressed\n");
@@ -119,27 +160,40 @@ static irqreturn_t button_interrupt_handler(int irq, void *dev_id) {
 
 // Attempt real I2C temperature/humidity reading; fall back to pseudo-random
 static void read_temperature_humidity(void) {
+    unsigned long flags;
+
     if (sensor_client) {
         // Simple example: read two 16-bit registers (0x00 temp, 0x01 humidity)
         s32 temp_raw = i2c_smbus_read_word_data(sensor_client, 0x00);
         s32 hum_raw  = i2c_smbus_read_word_data(sensor_client, 0x01);
 
         if (temp_raw >= 0 && hum_raw >= 0) {
-            // Interpret as hundredths; adjust as needed for your part
-            current_data.temperature = (float)be16_to_cpu((__be16)temp_raw) / 100.0f;
-            current_data.humidity    = (float)be16_to_cpu((__be16)hum_raw)  / 100.0f;
-            current_data.timestamp = jiffies;
-            data_ready = 1;
+            // Interpret as signed hundredths; adjust as needed for your part
+            u16 temp_word = be16_to_cpu((__be16)temp_raw);
+            u16 hum_word = be16_to_cpu((__be16)hum_raw);
+
+            spin_lock_irqsave(&sample_lock, flags);
+            current_sample.temp_raw = temp_word;
+            current_sample.humidity_raw = hum_word;
+            current_sample.temp_milli_c = (s16)temp_word * 10;
+            current_sample.humidity_milli_pct = hum_word * 10;
+            current_sample.flags &= ~SENSORHUB_FLAG_SIMULATED;
+            sample_updated();
+            spin_unlock_irqrestore(&sample_lock, flags);
             wake_up_interruptible(&data_wait_queue);
             return;
         }
     }
 
     // Fallback: simulated data for testing
-    current_data.temperature = 23.5f + (prandom_u32() % 100) / 10.0f;
-    current_data.humidity = 45.0f + (prandom_u32() % 300) / 10.0f;
-    current_data.timestamp = jiffies;
-    data_ready = 1;
+    spin_lock_irqsave(&sample_lock, flags);
+    current_sample.temp_raw = 0;
+    current_sample.humidity_raw = 0;
+    current_sample.temp_milli_c = 23500 + (prandom_u32() % 100) * 100;
+    current_sample.humidity_milli_pct = 45000 + (prandom_u32() % 300) * 100;
+    current_sample.flags |= SENSORHUB_FLAG_SIMULATED;
+    sample_updated();
+    spin_unlock_irqrestore(&sample_lock, flags);
     wake_up_interruptible(&data_wait_queue);
 }
 
@@ -183,8 +237,13 @@ static struct i2c_driver sensor_i2c_driver = {
 static int __init sensorhub_init(void) {
     int ret;
 
+    BUILD_BUG_ON(sizeof(struct sensorhub_sample) != 32);
     pr_info("PiRTOS: Initializing SensorHub driver\n");
 
+    // Before any IRQ or timer can update it
+    memset(&current_sample, 0, sizeof(current_sample));
+    current_sample.version = SENSORHUB_ABI_VERSION;
+
     // Register character device
     ret = alloc_chrdev_region(&dev_number, 0, 1, DEVICE_NAME);
     if (ret < 0) {
@@ -259,7 +318,6 @@ static int __init sensorhub_init(void) {
     if (ret)
         pr_warn("PiRTOS: Failed to register I2C driver\n");
 
-    memset(&current_data, 0, sizeof(current_data));
     pr_info("PiRTOS: SensorHub driver loaded successfully (major=%d)\n", major_number);
     return 0;
 }
@@ -295,4 +353,4 @@ module_exit(sensorhub_exit);
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("PiRTOS Developer");
 MODULE_DESCRIPTION("Real-time IoT Sensor Hub Driver");
-MODULE_VERSION("1.1");
+MODULE_VERSION("2.0");
@@ -2,21 +2,37 @@
 #define SENSORHUB_DRIVER_H
 
 #include <linux/ioctl.h>
+#include <linux/types.h>
 
 // Ioctl magic
 #define SENSORHUB_IOC_MAGIC 'S'
 
 // Commands
-#define SENSORHUB_RESET_DATA _IO(SENSORHUB_IOC_MAGIC, 1)
+#define SENSORHUB_RESET_DATA _IO(SENSORHUB_IOC_MAGIC, 1)  // clears data_ready
 #define SENSORHUB_GET_STATUS _IOR(SENSORHUB_IOC_MAGIC, 2, int)
+#define SENSORHUB_GET_ABI_VERSION _IOR(SENSORHUB_IOC_MAGIC, 3, int)  // record layout served
 
-// Data structure shared with userspace (SensorManager)
-struct sensorhub_data {
-    float temperature;
-    float humidity;
-    int motion_detected;
-    int button_pressed;
-    unsigned long timestamp;
-};
+// Record layout version carried in every sample
+#define SENSORHUB_ABI_VERSION 2
+
+// sensorhub_sample.flags
+#define SENSORHUB_FLAG_MOTION    0x01
+#define SENSORHUB_FLAG_BUTTON    0x02
+#define SENSORHUB_FLAG_SIMULATED 0x80  // no I2C sensor; values are synthetic
+
+// Record read() returns, shared with userspace (DeviceSensorSource). Fixed
+// point and explicitly sized, so the driver needs no FPU and the layout is
+// identical for armv7 and aarch64 userspace. 32 bytes.
+struct sensorhub_sample {
+    __u64 timestamp_ns;        // ktime_get_ns(), i.e. CLOCK_MONOTONIC
+    __u32 seq;                 // bumped on every update
+    __s32 temp_milli_c;        // milli-°C
+    __s32 humidity_milli_pct;  // milli-%RH
+    __u16 temp_raw;            // sensor words as read (0 when simulated)
+    __u16 humidity_raw;
+    __u8 flags;                // SENSORHUB_FLAG_*
+    __u8 version;              // SENSORHUB_ABI_VERSION
+    __u8 reserved[6];
+} __attribute__((packed));
 
 #endif /* SENSORHUB_DRIVER_H */
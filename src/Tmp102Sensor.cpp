@@ -8,6 +8,10 @@
 Tmp102Sensor::Tmp102Sensor(std::string bus, uint8_t addr)
   : bus_(std::move(bus)), addr_(addr) {}
 
+Tmp102Sensor::~Tmp102Sensor() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
 bool Tmp102Sensor::openBus() {
   fd_ = ::open(bus_.c_str(), O_RDWR);
   return fd_ >= 0;
@@ -19,19 +23,24 @@ bool Tmp102Sensor::begin() {
   return openBus() && setAddr();
 }
 
+bool Tmp102Sensor::readRegister(uint8_t reg, uint8_t* out, size_t n) {
+  if (::write(fd_, &reg, 1) != 1) return false;
+  return ::read(fd_, out, n) == static_cast<ssize_t>(n);
+}
+
+float Tmp102Sensor::decodeCelsius(uint8_t msb, uint8_t lsb) {
+  // 12-bit temperature: (data[0]<<4) | (data[1]>>4)
+  int16_t raw = ((msb << 8) | lsb) >> 4;
+  // sign extend if negative
+  if (raw & 0x800) raw |= 0xF000;
+  return raw * 0.0625f;
+}
+
 std::optional<float> Tmp102Sensor::readCelsius() {
   if (fd_ < 0 && !begin()) return std::nullopt;
 
   // TMP102 temp register 0x00 (2 bytes)
-  uint8_t reg = 0x00;
-  if (::write(fd_, &reg, 1) != 1) return std::nullopt;
   uint8_t data[2]{};
-  if (::read(fd_, data, 2) != 2) return std::nullopt;
-
-  // 12-bit temperature: (data[0]<<4) | (data[1]>>4)
-  int16_t raw = ((data[0] << 8) | data[1]) >> 4;
-  // sign extend if negative
-  if (raw & 0x800) raw |= 0xF000;
-  float c = raw * 0.0625f;
-  return c;
+  if (!readRegister(0x00, data, 2)) return std::nullopt;
+  return decodeCelsius(data[0], data[1]);
 }
@@ -0,0 +1,230 @@
+// Pass/fail checks for the ISR capture path (EventCapture.hpp) and its use
+// alongside cover<>. Run by ctest; exits non-zero if any check fails.
+//
+// The queue and snapshot are lock-free, so handlers push without any cover<>
+// section; cover<> only guards plain task/handler shared state (here a
+// counter), exactly as interrupts.cpp does.
+
+#include "Cover.hpp"
+#include "CoverPosix.hpp"
+#include "EventCapture.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+uint16_t check_of(uint32_t seq) { return static_cast<uint16_t>((seq * 2654435761u) >> 16); }
+
+EdgeEvent make_event(uint32_t seq) {
+    return {seq, seq, static_cast<uint16_t>(seq), check_of(seq)};
+}
+
+void fifo_and_wrap() {
+    EventCapture<EdgeEvent, 8> q;
+    EdgeEvent e;
+    check(!q.pop(e), "empty queue pops nothing");
+
+    // Several laps so every slot's sequence number wraps at least twice
+    uint32_t pushed = 0, popped = 0;
+    bool ordered = true;
+    for (int lap = 0; lap < 5; ++lap) {
+        for (int i = 0; i < 5; ++i) check(q.push(make_event(pushed++)), "push into free slot");
+        while (q.pop(e)) ordered &= e.seq == popped++;
+    }
+    check(ordered && popped == pushed, "events pop in push order across wrap-around");
+    check(q.dropped() == 0, "no drops below capacity");
+}
+
+void full_queue_drops() {
+    EventCapture<EdgeEvent, 8> q;
+    for (uint32_t i = 0; i < 8; ++i) q.push(make_event(i));
+    check(!q.push(make_event(8)) && !q.push(make_event(9)), "push fails when full");
+    check(q.dropped() == 2, "full pushes are counted as dropped");
+
+    EdgeEvent e;
+    check(q.pop(e) && e.seq == 0, "oldest event survives a full queue");
+    check(q.push(make_event(10)), "popping frees a slot");
+}
+
+void snapshot() {
+    EventSnapshot<EdgeEvent> s;
+    EdgeEvent e;
+    check(!s.load(e), "snapshot is empty before the first store");
+    s.store(make_event(7));
+    s.store(make_event(42));
+    check(s.load(e) && e.seq == 42 && e.level == check_of(42), "snapshot holds the latest store");
+}
+
+// Handlers as ISRs: a high-rate per-thread timer interrupts the consumer at
+// arbitrary instructions while it pushes, pops and reads cover-guarded state,
+// and SIGUSR1 interrupts producer threads mid-push. Every event must be
+// popped or counted dropped, and enough of them must come from handlers.
+namespace isr {
+
+using TestCover = cover<posix::signal_cover<SIGUSR1>>;
+
+EventCapture<EdgeEvent, 256> queue;
+TestCover cov;
+std::atomic<uint32_t> next_seq{0};
+std::atomic<uint32_t> handler_events{0};
+uint64_t handled = 0;  // consumer-thread handler runs, guarded by cov
+thread_local bool is_consumer = false;
+
+void handler(int) {
+    queue.push(make_event(next_seq.fetch_add(1, std::memory_order_relaxed)));
+    handler_events.fetch_add(1, std::memory_order_relaxed);
+    if (is_consumer) {
+        sync_lock<TestCover> lk(cov);
+        ++handled;
+    }
+}
+
+uint64_t elapsed_ns(const timespec& from) {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec - from.tv_sec) * 1000000000ull + now.tv_nsec - from.tv_nsec;
+}
+
+}
+
+void signal_capture() {
+    using namespace isr;
+    constexpr uint32_t kMinHandlerEvents = 20000;
+    constexpr uint32_t kEvents = 1u << 22;  // bound on ids, so the seen-set covers them
+    constexpr uint64_t kDeadlineNs = 10000000000ull;
+
+    struct sigaction sa{}, old{};
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, &old);
+    is_consumer = true;
+
+    // 20 us timer aimed at this thread: interrupts land mid-operation even
+    // on a single core, unlike signals from another thread
+    timer_t timer;
+    sigevent sev{};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGUSR1;
+    sev._sigev_un._tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    bool have_timer = timer_create(CLOCK_MONOTONIC, &sev, &timer) == 0;
+    check(have_timer, "per-thread timer created");
+    if (have_timer) {
+        itimerspec its{{0, 20000}, {0, 20000}};
+        timer_settime(timer, 0, &its, nullptr);
+    }
+
+    std::atomic<bool> stop{false}, stop_sender{false};
+    std::vector<pthread_t> producer_ids(2);
+    std::atomic<int> started{0};
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producer_ids.size(); ++p) {
+        producers.emplace_back([&, p] {
+            producer_ids[p] = pthread_self();
+            started.fetch_add(1);
+            while (!stop) {
+                queue.push(make_event(next_seq.fetch_add(1, std::memory_order_relaxed)));
+                for (int i = 0; i < 2000; ++i) asm volatile("" ::: "memory");
+            }
+        });
+    }
+    while (started.load() != static_cast<int>(producer_ids.size())) std::this_thread::yield();
+    std::thread sender([&] {
+        for (size_t k = 0; !stop_sender; ++k) {
+            pthread_kill(producer_ids[k % producer_ids.size()], SIGUSR1);
+            std::this_thread::yield();
+        }
+    });
+
+    uint64_t popped = 0, torn = 0, last_handled = 0, duplicate = 0;
+    bool monotonic = true;
+    std::vector<bool> seen(2 * kEvents);
+    auto drain = [&] {
+        EdgeEvent e;
+        while (queue.pop(e)) {
+            ++popped;
+            if (e.level != check_of(e.seq) || e.line != static_cast<uint16_t>(e.seq)) {
+                ++torn;
+            } else if (e.seq < seen.size()) {
+                if (seen[e.seq]) ++duplicate;
+                seen[e.seq] = true;
+            }
+        }
+    };
+
+    // Task-side pushes are paced so handler events are a real share of the run
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (handler_events.load(std::memory_order_relaxed) < kMinHandlerEvents &&
+           next_seq.load(std::memory_order_relaxed) < kEvents && elapsed_ns(start) < kDeadlineNs) {
+        for (int i = 0; i < 4; ++i) {
+            queue.push(make_event(next_seq.fetch_add(1, std::memory_order_relaxed)));
+        }
+        drain();
+        {
+            protect_lock<TestCover> lk(cov);
+            monotonic &= handled >= last_handled;
+            last_handled = handled;
+        }
+    }
+
+    // Sender first: a producer must not exit while it can still be signalled
+    stop_sender = true;
+    sender.join();
+    stop = true;
+    for (auto& t : producers) t.join();
+    if (have_timer) timer_delete(timer);
+
+    // No handler runs on this thread past this point: the last drain is final
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, &saved);
+    drain();
+    uint64_t total = next_seq.load();
+    uint32_t from_handlers = handler_events.load();
+    sigaction(SIGUSR1, &old, nullptr);
+    pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+    is_consumer = false;
+
+    std::printf("signal_capture: %llu events (%u from handlers, %llu on the consumer), "
+                "%llu popped, %u dropped\n",
+                static_cast<unsigned long long>(total), from_handlers,
+                static_cast<unsigned long long>(handled), static_cast<unsigned long long>(popped),
+                queue.dropped());
+    check(from_handlers >= kMinHandlerEvents, "enough events pushed from handlers");
+    check(handled > 0 && from_handlers > handled, "handlers interrupted the consumer and producers");
+    check(total < seen.size(), "sequence space large enough for the run");
+    check(popped + queue.dropped() == total, "every event popped or counted dropped");
+    check(torn == 0, "no torn events");
+    check(duplicate == 0, "no duplicated events");
+    check(monotonic && handled <= from_handlers, "cover-guarded counter tracks consumer handlers");
+}
+
+}
+
+int main() {
+    fifo_and_wrap();
+    full_queue_drops();
+    snapshot();
+    signal_capture();
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
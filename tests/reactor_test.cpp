@@ -0,0 +1,248 @@
+// Pass/fail checks for the coroutine reactor (reactor.h), per backend: a
+// ping-pong leaves nothing in flight, timers all fire and never early, poll
+// timeouts (also with a full submission queue), a read and a write pending on
+// one socket, and teardown with operations still in flight. Run by ctest;
+// exits non-zero if any check fails. pirtos_bench --filter reactor times the
+// same backends.
+
+#include "common.h"
+#include "reactor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+AsyncTask<> ping(Reactor& r, int out_fd, int in_fd, int rounds, int& trips) {
+    uint64_t v = 1;
+    for (; trips < rounds; ++trips) {
+        co_await r.write(out_fd, &v, sizeof(v));
+        co_await r.read(in_fd, &v, sizeof(v));
+    }
+    v = 2;
+    co_await r.write(out_fd, &v, sizeof(v));  // release pong
+}
+
+// Exactly one write is outstanding at a time, so the value read is the one
+// ping wrote: 2 ends the exchange.
+AsyncTask<> pong(Reactor& r, int in_fd, int out_fd) {
+    uint64_t v;
+    while (true) {
+        co_await r.read(in_fd, &v, sizeof(v));
+        if (v == 2) break;
+        co_await r.write(out_fd, &v, sizeof(v));
+    }
+}
+
+AsyncTask<> sleeper(Reactor& r, int rounds, int& woken, int& early) {
+    for (int i = 0; i < rounds; ++i) {
+        uint64_t due = monotonic_ns() + 1000000ull;
+        co_await r.sleep_until(due);
+        if (monotonic_ns() < due) ++early;
+        ++woken;
+    }
+}
+
+AsyncTask<> poll_timeout(Reactor& r, int fd, int64_t& result, uint64_t& waited) {
+    uint64_t t0 = monotonic_ns();
+    result = co_await r.poll(fd, POLLIN, std::chrono::milliseconds(5));
+    waited = monotonic_ns() - t0;
+}
+
+AsyncTask<> duplex_read(Reactor& r, int fd, bool& done) {
+    char c;
+    done = co_await r.read(fd, &c, 1) == 1;
+}
+
+AsyncTask<> duplex_write(Reactor& r, int fd, bool& done) {
+    char c = 'w';
+    done = co_await r.write(fd, &c, 1) == 1;
+}
+
+// Drains what the writer queued up, then answers the pending read
+AsyncTask<> duplex_peer(Reactor& r, int fd, size_t queued) {
+    char buf[4096];
+    while (queued > 0) {
+        int64_t n = co_await r.read(fd, buf, std::min(sizeof(buf), queued));
+        if (n <= 0) co_return;
+        queued -= static_cast<size_t>(n);
+    }
+    char c = 'r';
+    co_await r.write(fd, &c, 1);
+}
+
+// Runs r to completion, or stops it after two seconds. False if it had to be
+// stopped (a lost wakeup).
+bool run_with_watchdog(Reactor& r) {
+    std::atomic<bool> finished{false};
+    std::thread watchdog([&] {
+        for (int i = 0; i < 200 && !finished; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (!finished) r.stop();
+    });
+    r.run();
+    finished = true;
+    watchdog.join();
+    return r.in_flight() == 0;
+}
+
+// Both directions of one socket wait at the same time
+bool duplex_same_fd(Reactor& r) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0) return false;
+    char fill[4096] = {};
+    size_t queued = 0;
+    for (ssize_t n; (n = ::write(sv[0], fill, sizeof(fill))) > 0;) queued += static_cast<size_t>(n);
+
+    bool read_done = false, write_done = false;
+    r.spawn(duplex_read(r, sv[0], read_done));
+    r.spawn(duplex_write(r, sv[0], write_done));
+    r.spawn(duplex_peer(r, sv[1], queued));
+    bool finished = run_with_watchdog(r);
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return finished && read_done && write_done;
+}
+
+AsyncTask<> parked_read(Reactor& r, int fd) {
+    uint64_t v;
+    co_await r.read(fd, &v, sizeof(v));
+}
+
+AsyncTask<> poll_then_release(Reactor& r, int fd, const std::vector<int>& parked,
+                              int64_t& result, uint64_t& waited) {
+    co_await poll_timeout(r, fd, result, waited);
+    uint64_t one = 1;
+    for (int p : parked) {
+        if (::write(p, &one, sizeof(one)) != sizeof(one)) break;
+    }
+}
+
+// A four-entry queue already holding the wake read plus two parked reads:
+// the poll's POLL_ADD takes the last slot, so its linked timeout only works
+// if both are submitted together.
+bool poll_timeout_full_sq(bool uring, int64_t& result, uint64_t& waited) {
+    Reactor r(uring, 4);
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    std::vector<int> parked;
+    for (int i = 0; i < 2; ++i) {
+        parked.push_back(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+        r.spawn(parked_read(r, parked.back()));
+    }
+    r.spawn(poll_then_release(r, fd, parked, result, waited));
+    bool finished = run_with_watchdog(r);
+    ::close(fd);
+    for (int p : parked) ::close(p);
+    return finished;
+}
+
+// Counts live coroutine frames
+struct FrameGuard {
+    explicit FrameGuard(int& live) : live_(live) { ++live_; }
+    ~FrameGuard() { --live_; }
+    int& live_;
+};
+
+AsyncTask<> parked_forever(Reactor& r, int fd, int& live) {
+    FrameGuard guard(live);
+    uint64_t v;
+    co_await r.read(fd, &v, sizeof(v));
+}
+
+AsyncTask<> awaits_parked(Reactor& r, int fd, int& live) {
+    FrameGuard guard(live);
+    co_await parked_forever(r, fd, live);
+}
+
+AsyncTask<> sleeps_forever(Reactor& r, int& live) {
+    FrameGuard guard(live);
+    co_await r.sleep_for(std::chrono::hours(1));
+}
+
+// Destroys a reactor with a read, a nested task's read and a timer still in
+// flight. Returns the frames left alive afterwards.
+int teardown_leftovers(bool uring) {
+    int live = 0;
+    int a = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int b = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    {
+        Reactor r(uring);
+        r.spawn(parked_forever(r, a, live));
+        r.spawn(awaits_parked(r, b, live));
+        r.spawn(sleeps_forever(r, live));
+    }
+    ::close(a);
+    ::close(b);
+    return live;
+}
+
+void backend(bool uring) {
+    Reactor r(uring);
+    if (uring && r.backend() != Reactor::Backend::IoUring) {
+        std::printf("io_uring unavailable, skipping\n");
+        return;
+    }
+    const std::string name = r.backend_name();
+
+    int a = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int b = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int trips = 0;
+    r.spawn(pong(r, a, b));
+    r.spawn(ping(r, a, b, 10000, trips));
+    bool finished = run_with_watchdog(r);
+    check(finished && trips == 10000, name + ": ping-pong runs to completion");
+    check(r.in_flight() == 0, name + ": ping-pong leaves no operations in flight");
+
+    int woken = 0, early = 0;
+    r.spawn(sleeper(r, 50, woken, early));
+    r.run();
+    check(woken == 50, name + ": every timer wakes its task");
+    check(early == 0, name + ": no timer fires before its deadline");
+
+    int64_t result = -1;
+    uint64_t waited = 0;
+    r.spawn(poll_timeout(r, a, result, waited));  // `a` was drained by pong
+    r.run();
+    check(result == 0 && waited >= 5000000ull,
+          name + ": poll times out after 5 ms (returned " + std::to_string(result) + " after " +
+              std::to_string(waited) + " ns)");
+    ::close(a);
+    ::close(b);
+
+    check(duplex_same_fd(r), name + ": read and write pending on one fd both complete");
+
+    result = -1;
+    waited = 0;
+    check(poll_timeout_full_sq(uring, result, waited) && result == 0 && waited >= 5000000ull,
+          name + ": poll times out with a full submission queue (returned " +
+              std::to_string(result) + " after " + std::to_string(waited) + " ns)");
+
+    int live = teardown_leftovers(uring);
+    check(live == 0, name + ": " + std::to_string(live) + " task frames outlived their reactor");
+}
+
+}
+
+int main() {
+    backend(true);
+    backend(false);
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+// Pass/fail checks for report-by-exception filtering (report_filter.h). Run
+// by ctest; exits non-zero if any check fails. Compression ratio and cost
+// are measured by pirtos_bench --filter report_filter.
+
+#include "report_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+struct FilterCase {
+    const char* name;
+    ReportFilterConfig config;
+};
+
+ReportFilterConfig deadband_config() {
+    ReportFilterConfig c;
+    c.mode = ReportFilterConfig::Mode::Deadband;
+    c.max_silence_ns = 600000000000ull;  // 10 min heartbeat
+    return c;
+}
+
+ReportFilterConfig swinging_door_config() {
+    ReportFilterConfig c = deadband_config();
+    c.mode = ReportFilterConfig::Mode::SwingingDoor;
+    return c;
+}
+
+// 10 Hz series with slow drift, noise, 1.5 degree steps and motion/button
+// edges; the same one pirtos_bench compresses
+std::vector<SensorData> make_series(size_t n) {
+    std::vector<SensorData> series(n);
+    std::minstd_rand rng(7);
+    std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+    std::uniform_int_distribution<int> edge(0, 9999);
+    int motion = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double t = i * 0.1;
+        SensorData& d = series[i];
+        d.timestamp = static_cast<uint64_t>(i) * 100000000ull;
+        d.temperature = static_cast<float>(22.0 + 3.0 * std::sin(t / 3000.0)) + noise(rng) +
+                        ((i / 20000) % 2 ? 1.5f : 0.0f);
+        d.humidity = static_cast<float>(50.0 + 8.0 * std::sin(t / 5000.0)) + noise(rng) * 5;
+        if (edge(rng) == 0) motion = !motion;
+        d.motion_detected = motion;
+        d.button_pressed = edge(rng) == 1;
+    }
+    return series;
+}
+
+std::vector<SensorData> run_filter(const ReportFilterConfig& config,
+                                   const std::vector<SensorData>& series) {
+    SensorBatchPool pool(2);
+    BatchHandle in = pool.acquire();
+    BatchHandle out = pool.acquire();
+    ReportFilter filter(config);
+    std::vector<SensorData> reported;
+    auto drain = [&] {
+        for (uint32_t i = 0; i < out->count; ++i) reported.push_back(out->at(i));
+        out->clear();
+    };
+    for (size_t i = 0; i < series.size();) {
+        in->clear();
+        while (i < series.size() && !in->full()) in->push(series[i++]);
+        uint32_t next = 0;
+        while (next < in->count) {
+            next = filter.filter(*in, next, *out);
+            drain();
+        }
+    }
+    filter.flush(*out);
+    drain();
+    return reported;
+}
+
+// Every input sample must reconstruct from the reported series within its
+// channel deadband (held for Deadband, interpolated for SwingingDoor), and
+// every motion/button edge must be reported.
+void error_bound() {
+    const std::vector<SensorData> series = make_series(200000);
+    ReportFilterConfig sdt_rel = swinging_door_config();
+    sdt_rel.temperature = {0.0f, 0.005f};
+    sdt_rel.humidity = {0.0f, 0.01f};
+
+    for (const FilterCase& fc : {FilterCase{"deadband", deadband_config()},
+                                 FilterCase{"swinging_door", swinging_door_config()},
+                                 FilterCase{"swinging_door_relative", sdt_rel}}) {
+        const std::vector<SensorData> reported = run_filter(fc.config, series);
+        const bool hold = fc.config.mode == ReportFilterConfig::Mode::Deadband;
+        auto band = [&](const ChannelDeadband& b, float ref) {
+            return std::max(b.absolute, b.relative * std::fabs(ref));
+        };
+        double worst = 0.0;  // error / allowed
+        uint64_t edges_missed = 0;
+        size_t a = 0;
+        for (const SensorData& d : series) {
+            while (a + 1 < reported.size() && reported[a + 1].timestamp <= d.timestamp) ++a;
+            const SensorData& lo = reported[a];
+            const SensorData* hi = (a + 1 < reported.size()) ? &reported[a + 1] : nullptr;
+            const SensorData& prev = reported[a ? a - 1 : 0];
+
+            float t_est = lo.temperature, h_est = lo.humidity;
+            if (!hold && hi && hi->timestamp > lo.timestamp && d.timestamp > lo.timestamp) {
+                double f = double(d.timestamp - lo.timestamp) / double(hi->timestamp - lo.timestamp);
+                t_est = static_cast<float>(lo.temperature + f * (hi->temperature - lo.temperature));
+                h_est = static_cast<float>(lo.humidity + f * (hi->humidity - lo.humidity));
+            }
+            double t_allow = std::max(band(fc.config.temperature, lo.temperature),
+                                      band(fc.config.temperature, prev.temperature)) + 1e-4;
+            double h_allow = std::max(band(fc.config.humidity, lo.humidity),
+                                      band(fc.config.humidity, prev.humidity)) + 1e-4;
+            worst = std::max(worst, std::fabs(t_est - d.temperature) / t_allow);
+            worst = std::max(worst, std::fabs(h_est - d.humidity) / h_allow);
+            if (lo.motion_detected != d.motion_detected || lo.button_pressed != d.button_pressed) {
+                ++edges_missed;
+            }
+        }
+
+        std::printf("%s: %zu of %zu reported, max error %.3f of the deadband\n", fc.name,
+                    reported.size(), series.size(), worst);
+        check(reported.size() < series.size() / 10, std::string(fc.name) + ": compresses the series");
+        check(worst <= 1.0, std::string(fc.name) + ": error within the deadband");
+        check(edges_missed == 0, std::string(fc.name) + ": every edge reported");
+    }
+}
+
+// Timestamps stepping back (looped replay, restarted source): the first
+// sample after the step must be reported as a new anchor, with or without a
+// heartbeat to force it
+void step_back() {
+    ReportFilterConfig sdt_quiet = swinging_door_config();
+    sdt_quiet.max_silence_ns = 0;
+    for (const FilterCase& fc : {FilterCase{"deadband", deadband_config()},
+                                 FilterCase{"swinging_door", swinging_door_config()},
+                                 FilterCase{"swinging_door_no_heartbeat", sdt_quiet}}) {
+        SensorBatchPool pool(2);
+        BatchHandle in = pool.acquire();
+        BatchHandle out = pool.acquire();
+        ReportFilter filter(fc.config);
+        const uint64_t step_back_at = 5000000000ull;
+        for (uint64_t t : {100, 101, 102, 103, 5, 6, 7}) {
+            SensorData d{};
+            d.timestamp = t * 1000000000ull;
+            d.temperature = 22.0f;
+            d.humidity = 50.0f;
+            in->push(d);
+        }
+        filter.filter(*in, 0, *out);
+        filter.flush(*out);
+        bool anchored = false;
+        for (uint32_t i = 0; i < out->count; ++i) anchored |= out->timestamp[i] == step_back_at;
+        check(anchored, std::string(fc.name) + ": report after timestamps stepped back");
+    }
+}
+
+}
+
+int main() {
+    error_bound();
+    step_back();
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
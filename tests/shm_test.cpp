@@ -0,0 +1,227 @@
+// Pass/fail checks for the shared-memory sample channel (shm_channel.h,
+// pirtos_shm.h). Run by ctest; exits non-zero if any check fails.
+// pirtos_bench --filter shm measures publish cost and wake latency.
+
+#include "shm_channel.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+const std::string kName = "/pirtos_shm_test_" + std::to_string(::getpid());
+
+// Every field derives from the sample sequence, so a torn copy shows
+void fill_batch(SensorBatch& b, uint64_t first_seq, uint32_t n) {
+    b.first_seq = first_seq;
+    b.count = n;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t seq = first_seq + i;
+        b.timestamp[i] = seq;
+        b.temperature[i] = static_cast<float>(seq % 100000);
+        b.humidity[i] = static_cast<float>((seq * 7) % 100000);
+        b.flags[i] = static_cast<uint8_t>(seq & 3);
+    }
+}
+
+bool intact(const pirtos_shm_record& r) {
+    return r.temperature == static_cast<float>(r.sample_seq % 100000) &&
+           r.humidity == static_cast<float>((r.sample_seq * 7) % 100000) &&
+           r.flags == (r.sample_seq & 3) && r.timestamp_ns == r.sample_seq;
+}
+
+struct ReaderResult {
+    bool opened = false;
+    uint64_t read = 0;
+    uint64_t overruns = 0;
+    uint64_t torn = 0;
+    uint64_t unaccounted = 0;
+};
+
+void reader_thread(bool blocking, const std::atomic<bool>& stop, ReaderResult& out) {
+    ShmReader reader;
+    out.opened = reader.open(kName) == 0;
+    if (!out.opened) return;
+    uint64_t start = reader.next();
+    pirtos_shm_record recs[64];
+    while (true) {
+        bool done = stop.load(std::memory_order_acquire);
+        if (blocking) reader.wait(10);
+        int n = reader.read(recs, 64);
+        for (int i = 0; i < n; ++i) {
+            if (!intact(recs[i]) || recs[i].seq != recs[i].sample_seq) ++out.torn;
+        }
+        out.read += n > 0 ? n : 0;
+        if (done && n <= 0) break;
+    }
+    out.overruns = reader.overruns();
+    out.unaccounted = reader.next() - start - out.read - out.overruns;
+}
+
+// Readers racing a writer that laps them: every record is either read
+// intact or counted as an overrun, never torn or silently skipped.
+void concurrent_readers() {
+    ShmPublisher pub;
+    check(pub.open(kName, 256), "publisher creates the ring");
+    std::atomic<bool> stop{false};
+    std::vector<ReaderResult> results(3);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back(reader_thread, i == 0, std::cref(stop), std::ref(results[i]));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    SensorBatch batch;
+    uint64_t seq = 0;
+    for (int round = 0; round < 20000; ++round) {
+        fill_batch(batch, seq, 64);
+        pub.publish(batch);
+        seq += 64;
+    }
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    uint64_t read = 0, overruns = 0, torn = 0, unaccounted = 0;
+    bool opened = true;
+    for (const ReaderResult& r : results) {
+        opened &= r.opened;
+        read += r.read;
+        overruns += r.overruns;
+        torn += r.torn;
+        unaccounted += r.unaccounted;
+    }
+    std::printf("concurrent_readers: %llu published, %llu read, %llu overruns\n",
+                static_cast<unsigned long long>(seq), static_cast<unsigned long long>(read),
+                static_cast<unsigned long long>(overruns));
+    check(opened, "readers map the ring");
+    check(torn == 0, "no reader accepts a torn record");
+    check(unaccounted == 0, "every record read or counted as an overrun");
+    ::shm_unlink(kName.c_str());
+}
+
+// A reader that falls a whole ring behind skips what was overwritten,
+// counts it, and resumes with intact records.
+void lapped_reader() {
+    ShmPublisher pub;
+    pub.open(kName, 64);
+    ShmReader reader;
+    check(reader.open(kName) == 0, "reader opens the ring");
+    SensorBatch batch;
+    for (uint64_t seq = 0; seq < 200; seq += 50) {
+        fill_batch(batch, seq, 50);
+        pub.publish(batch);
+    }
+
+    pirtos_shm_record recs[256];
+    int n = reader.read(recs, 256);
+    bool ordered = n > 0 && intact(recs[0]);
+    for (int i = 1; i < n; ++i) ordered &= intact(recs[i]) && recs[i].seq == recs[i - 1].seq + 1;
+    check(n > 0 && n <= 64, "lapped reader gets at most one ring of records");
+    check(ordered, "records after the overrun are intact and consecutive");
+    check(reader.overruns() + static_cast<uint64_t>(n) == 200, "skipped records counted as overruns");
+    ::shm_unlink(kName.c_str());
+}
+
+// A publisher taking over a ring of the same size starts a new epoch that
+// mapped readers follow from record 0; a differently sized one retires the
+// ring and readers must reopen.
+void epochs() {
+    SensorBatch batch;
+    pirtos_shm_record recs[64];
+    {
+        ShmPublisher pub;
+        pub.open(kName, 64);
+        fill_batch(batch, 0, 10);
+        pub.publish(batch);
+    }
+    ShmReader reader;
+    check(reader.open(kName) == 0, "reader opens a ring whose publisher closed");
+    reader.seek_oldest();
+    check(reader.read(recs, 64) == 10, "records stay readable after the publisher closes");
+
+    {
+        ShmPublisher pub;
+        pub.open(kName, 64);
+        check(reader.wait(0), "a new epoch counts as news for a waiting reader");
+        fill_batch(batch, 1000, 5);
+        pub.publish(batch);
+        int n = reader.read(recs, 64);
+        check(n == 5 && recs[0].seq == 0 && recs[0].sample_seq == 1000,
+              "reader follows the new epoch from record 0");
+        check(reader.overruns() == 0, "an epoch change is not an overrun");
+    }
+
+    ShmPublisher resized;
+    resized.open(kName, 128);
+    check(reader.read(recs, 64) == -ESTALE, "a resized ring reads as stale");
+    check(reader.open(kName) == 0, "reader reopens the resized ring");
+    fill_batch(batch, 2000, 3);
+    resized.publish(batch);
+    check(reader.read(recs, 64) == 3 && recs[0].sample_seq == 2000, "reopened reader reads on");
+    ::shm_unlink(kName.c_str());
+}
+
+// Another user's ring (mode 0644): the reader falls back to a read-only
+// mapping, reads as usual, and its waits poll since it cannot register as a
+// futex waiter. Switching to an unprivileged uid needs root.
+void read_only_reader() {
+    if (::geteuid() != 0) {
+        std::printf("read_only_reader: skipped, needs root to switch uid\n");
+        return;
+    }
+    ShmPublisher pub;
+    pub.open(kName, 64);
+    pid_t child = ::fork();
+    if (child == 0) {
+        if (::setuid(65534) != 0) ::_exit(2);
+        pirtos_shm_reader r;
+        if (pirtos_shm_open(&r, kName.c_str()) != 0) ::_exit(3);
+        if (!r.read_only) ::_exit(4);
+        if (pirtos_shm_wait(&r, 2000) != 1) ::_exit(5);
+        pirtos_shm_record recs[8];
+        if (pirtos_shm_read(&r, recs, 8) != 3 || !intact(recs[0])) ::_exit(6);
+        ::_exit(0);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    SensorBatch batch;
+    fill_batch(batch, 0, 3);
+    pub.publish(batch);
+    int status = -1;
+    ::waitpid(child, &status, 0);
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+        std::printf("read_only_reader: child step %d failed\n", WEXITSTATUS(status));
+    }
+    check(child > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          "reader without write access opens, waits for and reads records");
+    ::shm_unlink(kName.c_str());
+}
+
+}
+
+int main() {
+    std::cout.setstate(std::ios::failbit);  // ShmPublisher::open's banner
+    concurrent_readers();
+    lapped_reader();
+    epochs();
+    read_only_reader();
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
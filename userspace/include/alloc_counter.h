@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstdint>
+
+// Test hook: counts global operator new calls across all threads. Only active
+// in binaries that link alloc_counter.cpp (which replaces operator new/delete);
+// elsewhere the counter stays at zero.
+namespace alloc_counter {
+uint64_t allocations();
+}
+
+#endif // ALLOC_COUNTER_H
@@ -19,6 +19,13 @@ struct SensorData {
           timestamp(0) {}
 };
 
+// Monotonic clock in nanoseconds; synthetic and replayed samples are
+// stamped on this timeline so end-to-end latency can be measured.
+inline uint64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 enum class LogLevel {
     DEBUG,
     INFO,
@@ -16,11 +16,48 @@
 #define DATA_LOG_INTERVAL_MS         2000
 #define NETWORK_UPDATE_INTERVAL_MS   1000
 
+// Sample batching: samples travel the pipeline in pooled SensorBatch blocks,
+// published when full or after SENSOR_BATCH_FLUSH_MS
+#define SENSOR_BATCH_CAPACITY        64
+#define SENSOR_BATCH_POOL_SIZE       32
+#define SENSOR_BATCH_FLUSH_MS        DATA_LOG_INTERVAL_MS
+
+// Time alignment: per-channel streams fused onto a common grid before
+// reporting; output trails input by at most LATENESS + PERIOD. 0 disables.
+#define TIME_ALIGN                   1
+#define TIME_ALIGN_PERIOD_MS         1000
+#define TIME_ALIGN_LATENESS_MS       2500  // >= sample period so values interpolate
+#define TIME_ALIGN_MAX_GAP_MS        10000 // wider gaps flag records stale
+
+// Shared-memory channel: every sample is also published into a POSIX shm
+// ring for local readers (pirtos_shm.h; pirtos_shm_tail). 0 disables.
+#define SHM_CHANNEL                  1
+#define SHM_CHANNEL_NAME             "/pirtos_samples"
+#define SHM_CHANNEL_CAPACITY         4096  // records, power of two
+
+// Report-by-exception: only samples that carry information reach the logger
+// and network (motion/button edges always do). 0 disables the filter.
+#define REPORT_BY_EXCEPTION          1
+#define REPORT_SWINGING_DOOR         1     // 0 = plain deadband
+#define REPORT_TEMP_DEADBAND_C       0.1f
+#define REPORT_TEMP_DEADBAND_REL     0.0f
+#define REPORT_HUMIDITY_DEADBAND     0.5f  // %RH
+#define REPORT_HUMIDITY_DEADBAND_REL 0.0f
+#define REPORT_MAX_SILENCE_MS        60000 // heartbeat
+
 // Network configuration (stubs for now)
 #define MQTT_BROKER          "localhost"
 #define MQTT_PORT            1883
 #define MQTT_TOPIC           "pirtos/sensors"
 
+// Site gateway uplink (pirtos_gateway): reported batches are also pushed
+// there as frames. HUB_ID must be unique per site. 0 disables.
+#define GATEWAY_UPLINK       0
+#define GATEWAY_HOST         "127.0.0.1"
+#define GATEWAY_PORT         7878
+#define GATEWAY_UPLINK_TCP   0     // 0 = UDP (never blocks the pipeline)
+#define HUB_ID               1
+
 // File paths
 #define DEVICE_PATH          "/dev/sensorhub"
 #define DATABASE_PATH        "/var/lib/pirtos/sensor_data.db"
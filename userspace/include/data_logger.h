@@ -1,11 +1,15 @@
 #pragma once
 #include "common.h"
+#include "gateway_link.h"
+#include "sensor_batch.h"
 #include <string>
 
 class DataLogger {
 public:
     explicit DataLogger(std::string path);
     void log_data(const SensorData& data);
+    void log_batch(const SensorBatch& batch);
+    void log_aggregates(uint64_t window_start_ns, const gateway::HubAggregate* aggs, size_t count);
 private:
     std::string path_;
 };
@@ -0,0 +1,39 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+// Milli-unit fixed point, the representation samples travel in from the
+// driver up to SensorManager's batches (milli-°C, milli-%RH). Floats only
+// appear at the edges: a whole batch column is converted at once when a
+// batch is published, and single values for the per-sample API.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace fixed {
+
+constexpr float kFromMilli = 0.001f;
+
+// Single values. Every conversion path multiplies by kFromMilli, so the
+// scalar and vector routines agree bit for bit.
+inline float from_milli(int32_t milli) { return static_cast<float>(milli) * kFromMilli; }
+
+// Rounds to nearest and saturates (NaN becomes 0)
+inline int32_t to_milli(float value) {
+    float scaled = value * 1000.0f;
+    if (!(scaled == scaled)) return 0;
+    if (scaled >= 2147483520.0f) return INT32_MAX;
+    if (scaled <= -2147483648.0f) return INT32_MIN;
+    return static_cast<int32_t>(std::lrint(scaled));
+}
+
+// Column conversion, SIMD where available (NEON on armv7/aarch64, SSE2 on
+// x86-64) with a scalar tail. `in` and `out` must not overlap.
+void milli_to_float(const int32_t* in, float* out, size_t n);
+
+// Reference loop, kept for benchmarking and verification
+void milli_to_float_scalar(const int32_t* in, float* out, size_t n);
+
+} // namespace fixed
+
+#endif // FIXED_POINT_H
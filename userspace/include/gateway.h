@@ -0,0 +1,141 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+// Site aggregator: receives batched sample streams from many hubs (UDP
+// datagrams and/or TCP streams, see gateway_link.h), tracks each hub's
+// sequence for gaps, and folds samples into per-hub time windows that are
+// released in time order across all hubs.
+//
+//   reactor thread   recv + header peek, frame copied to shard hub_id % N
+//   shard threads    parse, sequence/gap tracking, clock mapping, windows
+//   owner thread     poll(): merge closed windows by time, hand to the sink
+//
+// Hub timestamps are mapped onto the gateway's monotonic clock with a
+// per-hub offset, the minimum of (receive time - frame sent_ns) seen so
+// far. That estimate is off by at most the smallest observed one-way delay.
+
+#include "gateway_link.h"
+#include "reactor.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct GatewayConfig {
+    uint16_t udp_port = 7878;       // 0 disables
+    uint16_t tcp_port = 7878;       // 0 disables
+    unsigned shards = 0;            // 0 = one per online core
+    bool pin_shards = true;         // shard i on core i % cores
+    uint64_t window_ns = 1000000000ull;
+    // A hub's window closes once that hub's newest sample is this much
+    // past the window end (covers batching delay and reordering).
+    uint64_t lateness_ns = 3000000000ull;
+    // Silent hubs get their open windows closed after this long.
+    uint64_t idle_ns = 5000000000ull;
+    // Merge waits this long past window end + lateness for every hub's
+    // aggregate; later ones are forwarded on their own and counted late.
+    uint64_t merge_delay_ns = 500000000ull;
+    size_t frame_pool = 4096;       // frames in flight between receive and shards
+};
+
+// Per-hub counters; "received + gap_samples" accounts for every sample a hub
+// sent before its newest received frame.
+struct HubStats {
+    uint32_t hub_id = 0;
+    uint64_t frames = 0;
+    uint64_t samples = 0;
+    uint64_t gap_samples = 0;
+    uint64_t gap_events = 0;
+    uint64_t out_of_order = 0;   // frames behind the expected sequence
+    uint64_t late_samples = 0;   // arrived after their window closed
+    uint64_t resyncs = 0;        // new frame epochs (hub reconnected or restarted)
+    uint64_t next_seq = 0;
+    uint32_t epoch = 0;
+    int64_t clock_offset_ns = 0;
+};
+
+struct GatewayStats {
+    uint64_t frames = 0;
+    uint64_t samples = 0;
+    uint64_t gap_samples = 0;
+    uint64_t out_of_order = 0;
+    uint64_t late_samples = 0;
+    uint64_t resyncs = 0;
+    uint64_t malformed = 0;       // bad header or truncated frame
+    uint64_t frames_dropped = 0;  // frame pool exhausted (shards behind)
+    uint64_t hubs = 0;
+    uint64_t windows_released = 0;
+    uint64_t aggregates = 0;
+    uint64_t late_aggregates = 0;
+    std::vector<uint64_t> frames_per_shard;
+};
+
+class Gateway {
+public:
+    // Receives each released window: its start (gateway clock) and the
+    // hubs' aggregates for it, ordered by hub id.
+    using Sink = std::function<void(uint64_t window_start_ns, const gateway::HubAggregate* aggs,
+                                    size_t count)>;
+
+    explicit Gateway(const GatewayConfig& config);
+    ~Gateway();
+    Gateway(const Gateway&) = delete;
+    Gateway& operator=(const Gateway&) = delete;
+
+    bool start(Sink sink);
+    // Stops receiving and closes every open window; call flush() afterwards
+    // to release them.
+    void stop();
+    // Drops every TCP connection and reopens the listening socket, as a
+    // gateway restart would; hubs reconnect on their own.
+    void restart_tcp() { ++tcp_generation_; }
+
+    // Releases windows whose merge deadline passed by `now_ns` (monotonic).
+    // Returns the number of windows released.
+    size_t poll(uint64_t now_ns);
+    size_t flush();
+
+    GatewayStats stats() const;
+    // Valid once stop() has returned
+    std::vector<HubStats> hub_stats() const;
+
+private:
+    struct Frame;
+    class FramePool;
+    class Shard;
+
+    void receive_thread();
+    AsyncTask<> udp_loop(Reactor& reactor);
+    AsyncTask<> tcp_accept_loop(Reactor& reactor);
+    AsyncTask<> tcp_connection(Reactor& reactor, int fd);
+    void dispatch(const uint8_t* data, size_t len, uint32_t hub_id, uint64_t recv_ns);
+    void route(Frame* frame, uint32_t hub_id);
+    size_t release(uint64_t limit_ns, bool all);
+
+    GatewayConfig config_;
+    Sink sink_;
+    std::atomic<bool> running_{false};
+    int udp_fd_ = -1;
+    int tcp_fd_ = -1;
+    std::unique_ptr<FramePool> frames_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::thread receiver_;
+    std::atomic<uint64_t> malformed_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint32_t> tcp_generation_{0};
+
+    // Merge state (owner thread)
+    std::vector<gateway::HubAggregate> pending_;
+    std::vector<gateway::HubAggregate> collected_;
+    bool released_any_ = false;
+    uint64_t released_through_ = 0;  // newest released window start
+    uint64_t windows_released_ = 0;
+    uint64_t aggregates_ = 0;
+    uint64_t late_aggregates_ = 0;
+};
+
+#endif // GATEWAY_H
@@ -0,0 +1,202 @@
+#ifndef GATEWAY_LINK_H
+#define GATEWAY_LINK_H
+
+// Hub -> gateway wire format and the hub-side uplink.
+//
+// One frame carries one batch from one hub, laid out like SensorBatch
+// (little-endian; 32-byte header, then column arrays):
+//
+//   u32 magic  u16 version  u16 count  u32 hub_id  u32 epoch
+//   u64 first_seq           uplink sample sequence of sample 0
+//   u64 sent_ns             hub monotonic clock at send (clock mapping)
+//   u64 timestamp[count]  f32 temperature[count]  f32 humidity[count]
+//   u8  flags[count]
+//
+// At kFrameMaxSamples a frame stays below a 1500-byte MTU, so a UDP datagram
+// is exactly one frame; over TCP frames are simply concatenated.
+//
+// The epoch names one stream of first_seq values. An uplink picks a random
+// one at startup and bumps it on every TCP reconnect; the gateway restarts a
+// hub's sequence tracking when it changes, so an outage or a restarted hub
+// isn't read as a gap (or as a run of stale frames).
+
+#include "sensor_batch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "gateway frames are little-endian");
+
+namespace gateway {
+
+constexpr uint32_t kFrameMagic = 0x47545250;  // "PRTG"
+constexpr uint16_t kFrameVersion = 1;
+constexpr size_t kFrameHeaderBytes = 32;
+constexpr size_t kSampleBytes = 8 + 4 + 4 + 1;
+constexpr uint16_t kFrameMaxSamples = 64;
+constexpr size_t kFrameMaxBytes = kFrameHeaderBytes + kFrameMaxSamples * kSampleBytes;
+
+struct FrameHeader {
+    uint16_t count;
+    uint32_t hub_id;
+    uint32_t epoch;
+    uint64_t first_seq;
+    uint64_t sent_ns;
+};
+
+inline size_t frame_bytes(uint16_t count) { return kFrameHeaderBytes + count * kSampleBytes; }
+
+// Encodes batch samples [from, from + n) into `buf` (kFrameMaxBytes long).
+inline size_t encode_frame(uint32_t hub_id, uint32_t epoch, uint64_t first_seq, uint64_t sent_ns,
+                           const SensorBatch& batch, uint32_t from, uint16_t n, uint8_t* buf) {
+    std::memcpy(buf + 0, &kFrameMagic, 4);
+    std::memcpy(buf + 4, &kFrameVersion, 2);
+    std::memcpy(buf + 6, &n, 2);
+    std::memcpy(buf + 8, &hub_id, 4);
+    std::memcpy(buf + 12, &epoch, 4);
+    std::memcpy(buf + 16, &first_seq, 8);
+    std::memcpy(buf + 24, &sent_ns, 8);
+    uint8_t* p = buf + kFrameHeaderBytes;
+    std::memcpy(p, batch.timestamp + from, n * 8u);
+    p += n * 8u;
+    std::memcpy(p, batch.temperature + from, n * 4u);
+    p += n * 4u;
+    std::memcpy(p, batch.humidity + from, n * 4u);
+    p += n * 4u;
+    std::memcpy(p, batch.flags + from, n);
+    return frame_bytes(n);
+}
+
+// Validates the header of a frame at `buf`; `len` may cover more than one
+// frame (TCP). Returns false on a malformed header.
+inline bool decode_header(const uint8_t* buf, size_t len, FrameHeader& h) {
+    if (len < kFrameHeaderBytes) return false;
+    uint32_t magic;
+    uint16_t version;
+    std::memcpy(&magic, buf + 0, 4);
+    std::memcpy(&version, buf + 4, 2);
+    std::memcpy(&h.count, buf + 6, 2);
+    std::memcpy(&h.hub_id, buf + 8, 4);
+    std::memcpy(&h.epoch, buf + 12, 4);
+    std::memcpy(&h.first_seq, buf + 16, 8);
+    std::memcpy(&h.sent_ns, buf + 24, 8);
+    return magic == kFrameMagic && version == kFrameVersion && h.count <= kFrameMaxSamples;
+}
+
+// Copies a complete frame's samples into `out` (replacing its contents).
+inline bool decode_frame(const uint8_t* buf, size_t len, FrameHeader& h, SensorBatch& out) {
+    if (!decode_header(buf, len, h) || len < frame_bytes(h.count) ||
+        h.count > SensorBatch::kCapacity) {
+        return false;
+    }
+    const uint8_t* p = buf + kFrameHeaderBytes;
+    std::memcpy(out.timestamp, p, h.count * 8u);
+    p += h.count * 8u;
+    std::memcpy(out.temperature, p, h.count * 4u);
+    p += h.count * 4u;
+    std::memcpy(out.humidity, p, h.count * 4u);
+    p += h.count * 4u;
+    std::memcpy(out.flags, p, h.count);
+    out.first_seq = h.first_seq;
+    out.count = h.count;
+    return true;
+}
+
+// Per-hub, per-window summary the gateway forwards instead of raw samples.
+// window_start_ns is on the gateway's clock.
+struct HubAggregate {
+    uint32_t hub_id = 0;
+    uint32_t count = 0;
+    uint64_t window_start_ns = 0;
+    float temp_min = 0.0f, temp_mean = 0.0f, temp_max = 0.0f;
+    float hum_min = 0.0f, hum_mean = 0.0f, hum_max = 0.0f;
+    uint16_t motion_events = 0;  // rising edges
+    uint16_t button_events = 0;
+    uint32_t gap_samples = 0;    // samples detected lost in this window
+};
+
+} // namespace gateway
+
+// Hub side: pushes published batches to a site gateway and never blocks the
+// pipeline. Over UDP a full socket buffer drops the datagram. Over TCP, bytes
+// the kernel won't take yet wait in a bounded outbound buffer and go out on
+// the next send() or flush(); a frame that doesn't fit is dropped whole, so
+// the stream stays framed. Dropped samples show up at the gateway as a gap.
+//
+// A broken TCP stream is reopened from send() with a nonblocking connect,
+// backing off from 100 ms to 5 s between attempts; frames sent while it is
+// down are dropped. Every new connection starts a new epoch.
+class GatewayUplink {
+public:
+    GatewayUplink() = default;
+    ~GatewayUplink() { close(); }
+    GatewayUplink(const GatewayUplink&) = delete;
+    GatewayUplink& operator=(const GatewayUplink&) = delete;
+
+    // Resolves the gateway and starts connecting without waiting: a TCP
+    // stream comes up (and is retried) from send(). False only if the
+    // address can't be resolved or a UDP socket can't be set up. Each call
+    // starts a new epoch numbered from sample 0, as a rebooted hub does.
+    bool connect(const std::string& host, uint16_t port, uint32_t hub_id, bool tcp);
+    // Blocks until the TCP stream is up, for tools that want a clean start;
+    // a stream the gateway has closed counts as down and is reopened
+    bool wait_connected(int timeout_ms);
+    // Closes the link for good (no reconnects)
+    void close();
+    bool connected() const { return fd_ >= 0 && !connecting_; }
+
+    // Sends the batch as one or more frames stamped with `sent_ns` (the hub's
+    // monotonic clock, which batch timestamps use too). Frames are numbered
+    // by the uplink's own sample sequence, so the gateway's gap count is
+    // exactly what the link lost, whatever filtering came before. False if
+    // any frame was dropped.
+    bool send(const SensorBatch& batch, uint64_t sent_ns);
+    // Advances the sequence without sending: samples lost before the uplink
+    // (or dropped on purpose by a simulator) then show up as a gap.
+    void skip(uint64_t samples) { next_seq_ += samples; }
+    // Hands queued TCP bytes to the kernel as far as it takes them; true
+    // once nothing is left queued.
+    bool flush();
+
+    uint64_t frames_sent() const { return frames_sent_; }
+    uint64_t frames_dropped() const { return frames_dropped_; }
+    uint64_t reconnects() const { return reconnects_; }
+
+private:
+    static constexpr size_t kOutboundBytes = 16 * gateway::kFrameMaxBytes;
+    static constexpr uint64_t kBackoffMinNs = 100000000ull;
+    static constexpr uint64_t kBackoffMaxNs = 5000000000ull;
+
+    bool send_frame(size_t len);
+    void queue(const uint8_t* data, size_t len);
+    bool reconnect();
+    bool peer_closed() const;
+    void check_peer();
+    void link_up();
+    void link_down();
+
+    int fd_ = -1;
+    bool tcp_ = false;
+    bool connecting_ = false;     // nonblocking connect in progress
+    sockaddr_storage addr_{};     // resolved once; reconnects skip DNS
+    socklen_t addr_len_ = 0;
+    uint64_t retry_at_ns_ = 0;
+    uint64_t backoff_ns_ = kBackoffMinNs;
+    uint64_t reconnects_ = 0;
+    bool was_up_ = false;         // reconnects_ counts links after the first
+    uint32_t hub_id_ = 0;
+    uint32_t epoch_ = 0;
+    uint64_t next_seq_ = 0;
+    uint64_t frames_sent_ = 0;
+    uint64_t frames_dropped_ = 0;
+    std::unique_ptr<uint8_t[]> out_;  // TCP outbound buffer, kOutboundBytes
+    size_t out_head_ = 0;
+    size_t out_len_ = 0;
+    uint8_t buf_[gateway::kFrameMaxBytes];
+};
+
+#endif // GATEWAY_LINK_H
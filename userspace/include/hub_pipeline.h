@@ -0,0 +1,79 @@
+#ifndef HUB_PIPELINE_H
+#define HUB_PIPELINE_H
+
+#include "data_logger.h"
+#include "network_manager.h"
+#include "report_filter.h"
+#include "sensor_batch.h"
+#include "time_aligner.h"
+
+#include <cstdint>
+#include <functional>
+
+class SensorManager;
+
+struct HubPipelineConfig {
+    bool time_align = true;
+    TimeAlignerConfig align;
+    bool report_by_exception = true;
+    ReportFilterConfig report;
+};
+
+// Where a batch has just been delivered (load test latency probes)
+enum class HubSink : uint8_t { Logger, Network, Alerts };
+
+// The stages config.h enables for pirtos_hub (TIME_ALIGN*, REPORT_*).
+HubPipelineConfig default_pipeline_config();
+
+// What the hub does with every batch SensorManager publishes:
+//
+//   [TimeAligner] -> [ReportFilter] -> DataLogger + NetworkManager
+//   alerts on every raw sample
+//
+// pirtos_hub and pirtos_loadtest both run it, so the load test measures the
+// chain the hub ships. Everything runs synchronously on the caller's thread.
+class HubPipeline {
+public:
+    HubPipeline(const HubPipelineConfig& config, SensorManager& sensors, DataLogger& logger,
+                NetworkManager& network);
+
+    void handle(const SensorBatch& batch);
+    // End of input: releases what the aligner and filter still hold.
+    // `next_seq` numbers the final aligned records.
+    void finish(uint64_t next_seq);
+
+    // Called after each sink has taken a batch: the logger and network get
+    // what the aligner/filter pass on, alerts every raw batch
+    void on_delivered(std::function<void(HubSink, const SensorBatch&)> hook) {
+        on_delivered_ = std::move(hook);
+    }
+
+    const HubPipelineConfig& config() const { return config_; }
+    const TimeAligner& aligner() const { return aligner_; }
+    const ReportFilter& filter() const { return filter_; }
+    uint64_t samples_published() const { return samples_published_; }
+    // Samples that never reached the sinks because a stage pool was empty
+    uint64_t samples_dropped() const { return samples_dropped_; }
+
+private:
+    void publish(const SensorBatch& batch);
+    void report(const SensorBatch& batch);
+    void report_aligned(uint64_t first_seq, bool flush);
+
+    HubPipelineConfig config_;
+    SensorManager& sensors_;
+    DataLogger& logger_;
+    NetworkManager& network_;
+    TimeAligner aligner_;
+    ReportFilter filter_;
+    // Sinks see a const SensorBatch& and cannot keep a handle, so each stage
+    // holds at most one batch at a time; an empty pool means a sink re-entered
+    // the pipeline, and the samples are counted as dropped.
+    SensorBatchPool report_pool_;
+    SensorBatchPool align_pool_;
+    std::function<void(HubSink, const SensorBatch&)> on_delivered_;
+    uint64_t samples_published_ = 0;
+    uint64_t samples_dropped_ = 0;
+};
+
+#endif // HUB_PIPELINE_H
@@ -0,0 +1,71 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+
+// Fixed-size log-linear histogram for nanosecond latencies: 16 linear
+// sub-buckets per power of two, so percentiles are within ~6% and recording
+// never allocates.
+class LatencyHistogram {
+public:
+    void record(uint64_t ns) {
+        ++buckets_[bucket_of(ns)];
+        ++count_;
+        if (ns > max_) max_ = ns;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < buckets_.size(); ++i) buckets_[i] += other.buckets_[i];
+        count_ += other.count_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+
+    // Upper bound of the bucket holding the p-th percentile (0..100).
+    uint64_t percentile(double p) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * (count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                uint64_t upper = upper_bound_of(i);
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+    void reset() {
+        buckets_.fill(0);
+        count_ = 0;
+        max_ = 0;
+    }
+
+private:
+    static constexpr unsigned kSubBits = 4;
+    static constexpr unsigned kSub = 1u << kSubBits;
+
+    static size_t bucket_of(uint64_t v) {
+        if (v < kSub) return static_cast<size_t>(v);
+        unsigned msb = 63 - __builtin_clzll(v);
+        unsigned shift = msb - kSubBits;
+        return (shift + 1) * kSub + static_cast<size_t>((v >> shift) & (kSub - 1));
+    }
+
+    static uint64_t upper_bound_of(size_t i) {
+        if (i < kSub) return i;
+        unsigned shift = static_cast<unsigned>(i / kSub) - 1;
+        uint64_t base = (kSub + (i % kSub)) << shift;
+        return base + ((1ull << shift) - 1);
+    }
+
+    std::array<uint64_t, (64 - kSubBits + 1) * kSub> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -1,2 +1,20 @@
 #pragma once
-#include "common.h
+#include "common.h"
+#include "gateway_link.h"
+#include "sensor_batch.h"
+#include <string>
+
+class NetworkManager {
+public:
+    void broadcast_data(const SensorData& data);
+    void broadcast_batch(const SensorBatch& batch);
+    // Gateway mode: forwards a released window's per-hub aggregates upstream
+    void broadcast_aggregates(uint64_t window_start_ns, const gateway::HubAggregate* aggs,
+                              size_t count);
+
+    // Also push every broadcast batch to a site gateway (pirtos_gateway)
+    bool connect_gateway(const std::string& host, uint16_t port, uint32_t hub_id, bool tcp);
+
+private:
+    GatewayUplink uplink_;
+};
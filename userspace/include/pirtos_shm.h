@@ -0,0 +1,108 @@
+#ifndef PIRTOS_SHM_H
+#define PIRTOS_SHM_H
+
+// Shared-memory sample channel: SensorManager publishes every sample into a
+// POSIX shm ring that any number of local processes read without syscalls.
+// This header is the whole ABI (plain C, usable from C and C++).
+//
+//   [header page]  descriptor (guarded by desc_seq), write_seq, futex words
+//   [slots]        capacity records of record_size bytes, slot n & (capacity-1)
+//
+// Writing record n, the publisher sets the slot's seq to 2n+1, stores the
+// payload, then sets seq to 2n+2 and finally advances write_seq. A reader
+// copies a slot and accepts it only if seq was 2n+2 both before and after
+// the copy; anything else means the writer lapped it (an overrun). The
+// writer never waits for readers.
+//
+// Records only ever grow at the end: a reader copies the fields it knows
+// (min of its and the ring's record_size). PIRTOS_SHM_VERSION changes only
+// for incompatible layouts.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIRTOS_SHM_MAGIC         0x4d485350u  // "PSHM"
+#define PIRTOS_SHM_VERSION       1u
+#define PIRTOS_SHM_HEADER_BYTES  4096u        // slots start on the next page
+#define PIRTOS_SHM_EPOCH_RETIRED UINT64_MAX   // ring replaced; reopen by name
+
+struct pirtos_shm_header {
+    // Descriptor; desc_seq is odd while a publisher (re)initializes it
+    uint32_t desc_seq;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;       // power of two
+    uint32_t reserved0;
+    uint64_t epoch;          // bumped whenever a publisher takes the ring over
+    uint8_t pad0[32];
+
+    // Writer state, on its own cache line
+    uint64_t write_seq;      // records published so far (this epoch)
+    uint32_t futex;          // bumped after every publish
+    uint32_t waiters;        // readers blocked on futex (see pirtos_shm_wait)
+    uint8_t pad1[48];
+};
+
+// Record layout version 1 (40 bytes)
+struct pirtos_shm_record {
+    uint64_t seq;            // slot seqlock; reader copies get the ring index
+    uint64_t sample_seq;     // SensorManager sample sequence
+    uint64_t timestamp_ns;   // sample time, CLOCK_MONOTONIC
+    float temperature;       // °C
+    float humidity;          // %RH
+    uint8_t flags;           // PIRTOS_SHM_FLAG_* (= SENSOR_FLAG_*)
+    uint8_t reserved[7];
+};
+
+#define PIRTOS_SHM_RECORD_V1_BYTES 40u
+
+#define PIRTOS_SHM_FLAG_MOTION 0x01u
+#define PIRTOS_SHM_FLAG_BUTTON 0x02u
+#define PIRTOS_SHM_FLAG_STALE  0x04u
+
+typedef struct pirtos_shm_reader {
+    struct pirtos_shm_header* header;  // header page, read-write for futex waits if allowed
+    const uint8_t* slots;              // mapped read-only
+    size_t slots_bytes;
+    uint64_t epoch;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint64_t next;                     // ring index of the next record to read
+    uint64_t overruns;                 // records the writer overwrote before we read them
+    int read_only;                     // no write access: waits poll every millisecond
+} pirtos_shm_reader;
+
+// Maps ring `name` (e.g. "/pirtos_samples") and positions the reader at the
+// live end. Read access to the ring is enough; without write access the
+// reader cannot sleep on the futex and pirtos_shm_wait() polls instead.
+// Returns 0, or a negative errno (-EPROTO on a foreign layout).
+int pirtos_shm_open(pirtos_shm_reader* r, const char* name);
+void pirtos_shm_close(pirtos_shm_reader* r);
+
+// Rewinds to the oldest record still in the ring.
+void pirtos_shm_seek_oldest(pirtos_shm_reader* r);
+
+// Copies up to `max` records published since the last call; never blocks and
+// makes no syscalls. Returns the number copied, or -ESTALE once the ring has
+// been replaced with a different layout (close and reopen). Overwritten
+// records are skipped and added to r->overruns.
+int pirtos_shm_read(pirtos_shm_reader* r, struct pirtos_shm_record* out, size_t max);
+
+// Blocks until a record past r->next is published or timeout_ms elapses
+// (-1 waits forever). Returns 1 when records are available, 0 on timeout.
+// A reader killed while blocked here leaves `waiters` raised for the life of
+// the ring. Nothing is lost, but every publish then costs a futex wake
+// syscall until the ring is recreated. Clearing the count in place could
+// race a live reader's registration and lose its wakeup.
+int pirtos_shm_wait(pirtos_shm_reader* r, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIRTOS_SHM_H
@@ -0,0 +1,221 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+// Single-threaded I/O reactor with C++20 coroutines.
+//
+// Device reads, file appends, socket sends and timers are written as
+// straight-line `co_await` code and multiplexed on the calling thread:
+//
+//   AsyncTask<> pump(Reactor& r, int fd) {
+//       char buf[64];
+//       ssize_t n = co_await r.read(fd, buf, sizeof(buf));
+//       co_await r.sleep_for(std::chrono::milliseconds(10));
+//   }
+//   Reactor reactor;            // io_uring, or epoll if unavailable
+//   reactor.spawn(pump(reactor, fd));
+//   reactor.run();
+//
+// With io_uring any fd works. The epoll fallback needs O_NONBLOCK fds for
+// sockets/devices (regular files complete synchronously) and takes at most one
+// pending input op (read, poll for POLLIN) plus one pending output op (write,
+// send, poll for POLLOUT only) per fd; code sticks to that on either backend.
+// Results follow the syscall convention: >= 0 on success, -errno on failure.
+// Everything except stop() must be called on the reactor's thread.
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+class Reactor;
+
+// Lazily started coroutine; awaiting it runs it to completion and yields its
+// value. Reactor::spawn() runs one detached.
+template <typename T = void>
+class AsyncTask;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    bool detached = false;
+    // Detached tasks sit on their reactor's list until they finish, so the
+    // reactor can destroy the ones still suspended when it goes away
+    PromiseBase* prev = nullptr;
+    PromiseBase* next = nullptr;
+
+    void unlink() noexcept {
+        if (prev) prev->next = next;
+        if (next) next->prev = prev;
+        prev = next = nullptr;
+    }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            PromiseBase& p = h.promise();
+            if (p.detached) {
+                p.unlink();
+                h.destroy();
+                return std::noop_coroutine();
+            }
+            return p.continuation ? p.continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    // The hub is built without exception-based error paths
+    void unhandled_exception() noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+    AsyncTask<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    AsyncTask<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+};
+
+} // namespace detail
+
+template <typename T>
+class AsyncTask {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    AsyncTask() = default;
+    explicit AsyncTask(Handle h) : handle_(h) {}
+    AsyncTask(AsyncTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    AsyncTask& operator=(AsyncTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~AsyncTask() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+    T await_resume() {
+        if constexpr (!std::is_void_v<T>) return std::move(*handle_.promise().value);
+    }
+
+private:
+    friend class Reactor;
+    Handle release() { return std::exchange(handle_, {}); }
+
+    Handle handle_;
+};
+
+namespace detail {
+template <typename T>
+AsyncTask<T> Promise<T>::get_return_object() noexcept {
+    return AsyncTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+inline AsyncTask<void> Promise<void>::get_return_object() noexcept {
+    return AsyncTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+} // namespace detail
+
+// One in-flight operation; lives in the awaiting coroutine's frame.
+struct IoOp {
+    enum class Kind { Read, Write, Send, Poll, Timeout };
+
+    Kind kind = Kind::Read;
+    int fd = -1;
+    void* buf = nullptr;
+    size_t len = 0;
+    int64_t offset = -1;        // Read/Write: -1 = current file position
+    int flags = 0;              // Send: MSG_*; Poll: POLL* event mask
+    uint64_t deadline_ns = 0;   // Timeout; Poll: 0 = no timeout
+
+    std::coroutine_handle<> handle;
+    int64_t result = 0;
+    size_t heap_index = SIZE_MAX;  // epoll backend timer heap slot
+    IoOp* prev = nullptr;          // Reactor's in-flight list
+    IoOp* next = nullptr;
+};
+
+class IoAwaitable {
+public:
+    IoAwaitable(Reactor* reactor, const IoOp& op) : reactor_(reactor), op_(op) {}
+
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> h);
+    int64_t await_resume() const { return op_.result; }
+
+private:
+    Reactor* reactor_;
+    IoOp op_;
+};
+
+class Reactor {
+public:
+    enum class Backend { IoUring, Epoll };
+
+    // Picks io_uring when the kernel allows it, epoll otherwise.
+    explicit Reactor(bool prefer_io_uring = true, unsigned queue_depth = 64);
+    // Cancels what is still in flight, waits until the kernel has let go of
+    // those buffers, then destroys the spawned tasks that are still suspended.
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    bool valid() const;
+    Backend backend() const;
+    const char* backend_name() const;
+
+    IoAwaitable read(int fd, void* buf, size_t len, int64_t offset = -1);
+    IoAwaitable write(int fd, const void* buf, size_t len, int64_t offset = -1);
+    IoAwaitable send(int fd, const void* buf, size_t len, int flags = 0);
+    // Resolves to the ready event mask, or 0 if the deadline passed first
+    IoAwaitable poll(int fd, short events, std::chrono::nanoseconds timeout);
+    IoAwaitable sleep_until(uint64_t deadline_ns);  // monotonic_ns() timeline
+    IoAwaitable sleep_for(std::chrono::nanoseconds d);
+
+    // Starts a detached task; it runs until its first suspension right away
+    // and is destroyed when it finishes.
+    void spawn(AsyncTask<void> task);
+
+    // Runs until stop() or until nothing is in flight.
+    void run();
+    // Thread-safe; wakes run() from any thread or signal handler.
+    void stop();
+
+    size_t in_flight() const { return in_flight_; }
+
+    class Impl;
+
+private:
+    friend class IoAwaitable;
+    bool try_complete(IoOp& op);
+    void submit(IoOp& op);
+    void retire(IoOp& op);
+
+    std::unique_ptr<Impl> impl_;
+    size_t in_flight_ = 0;
+    IoOp* pending_ = nullptr;       // head of the in-flight list
+    detail::PromiseBase spawned_;   // sentinel of the detached-task list
+};
+
+#endif // REACTOR_H
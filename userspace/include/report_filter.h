@@ -0,0 +1,87 @@
+#ifndef REPORT_FILTER_H
+#define REPORT_FILTER_H
+
+#include "sensor_batch.h"
+
+#include <cstdint>
+
+// Per-channel change threshold: a value "carries information" once it moves
+// more than max(absolute, relative * |last reported value|).
+struct ChannelDeadband {
+    float absolute = 0.0f;
+    float relative = 0.0f;
+};
+
+struct ReportFilterConfig {
+    enum class Mode {
+        // Report a sample when any channel leaves its deadband. Holding the
+        // last reported value reconstructs every dropped sample within it.
+        Deadband,
+        // Swinging-door trending: report trend corners. Linear interpolation
+        // between reported points reconstructs every dropped sample within
+        // the channel deadband. Corner values lie on the door and may differ
+        // from the raw sample by up to the deadband.
+        SwingingDoor,
+    };
+
+    Mode mode = Mode::Deadband;
+    ChannelDeadband temperature{0.1f, 0.0f};
+    ChannelDeadband humidity{0.5f, 0.0f};
+    uint64_t max_silence_ns = 60000000000ull;  // heartbeat; 0 disables
+};
+
+// Report-by-exception stage between SensorManager and the logger/network
+// sinks. Motion and button edges always pass, and no channel stays silent for
+// longer than max_silence_ns (as measured in sample timestamps). A sample
+// older than the last report (the clock stepped back) is reported and
+// becomes the new anchor.
+class ReportFilter {
+public:
+    explicit ReportFilter(const ReportFilterConfig& config);
+
+    // Consumes in[from..] and appends reported samples to `out`. Stops early
+    // when `out` is nearly full; returns the index of the next unconsumed
+    // input sample (in.count once the whole batch is consumed).
+    uint32_t filter(const SensorBatch& in, uint32_t from, SensorBatch& out);
+
+    // Emits a held trend point (SwingingDoor) so the reported series covers
+    // every consumed sample. Needs one free slot in `out`.
+    void flush(SensorBatch& out);
+
+    void reset();
+    uint64_t samples_in() const { return samples_in_; }
+    uint64_t samples_out() const { return samples_out_; }
+
+private:
+    static constexpr int kChannels = 2;  // temperature, humidity
+
+    struct Sample {
+        uint64_t timestamp;
+        float value[kChannels];
+        uint8_t flags;
+    };
+
+    float deadband(int channel, float reference) const;
+    bool exceeds_deadband(const Sample& s) const;
+    void restart_doors(const Sample& anchor);
+    Sample door_point(const Sample& p) const;
+    void emit(const Sample& s, SensorBatch& out);
+    void process(const Sample& s, SensorBatch& out);
+
+    ReportFilterConfig config_;
+    ChannelDeadband bands_[kChannels];
+
+    bool have_anchor_;
+    bool have_pending_;
+    bool have_prev_;
+    Sample anchor_;    // last reported sample
+    Sample pending_;   // newest unreported sample (SwingingDoor)
+    uint8_t prev_flags_;
+    double min_up_[kChannels];
+    double max_low_[kChannels];
+
+    uint64_t samples_in_;
+    uint64_t samples_out_;
+};
+
+#endif // REPORT_FILTER_H
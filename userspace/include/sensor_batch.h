@@ -0,0 +1,134 @@
+#ifndef SENSOR_BATCH_H
+#define SENSOR_BATCH_H
+
+#include "common.h"
+#include "config.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Per-sample bits in SensorBatch::flags
+enum SensorFlag : uint8_t {
+    SENSOR_FLAG_MOTION = 1u << 0,
+    SENSOR_FLAG_BUTTON = 1u << 1,
+    SENSOR_FLAG_STALE = 1u << 2,   // TimeAligner: a channel had no recent reading
+};
+
+class SensorBatchPool;
+
+// Fixed-capacity structure-of-arrays block of samples. Each column starts on
+// its own cache line so per-channel scans touch only that channel's lines.
+// Batches live in a SensorBatchPool and are passed around by BatchHandle.
+//
+// Value columns are float on purpose. Samples stay in milli-unit fixed point
+// (fixed_point.h) from the driver until SensorManager::publish_batch, which
+// converts each column in one pass. Everything downstream does float maths
+// (aligner interpolation, swinging-door slopes, gateway aggregates) or
+// carries floats in its format (logger, network, the shm record ABI).
+struct SensorBatch {
+    static constexpr size_t kCapacity = SENSOR_BATCH_CAPACITY;
+
+    alignas(64) uint64_t timestamp[kCapacity];
+    alignas(64) float temperature[kCapacity];
+    alignas(64) float humidity[kCapacity];
+    alignas(64) uint8_t flags[kCapacity];
+
+    uint64_t first_seq = 0;  // sequence number of sample 0
+    uint32_t count = 0;
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == kCapacity; }
+    void clear() { count = 0; first_seq = 0; }
+
+    void push(const SensorData& data) {
+        timestamp[count] = data.timestamp;
+        temperature[count] = data.temperature;
+        humidity[count] = data.humidity;
+        flags[count] = static_cast<uint8_t>((data.motion_detected ? SENSOR_FLAG_MOTION : 0) |
+                                            (data.button_pressed ? SENSOR_FLAG_BUTTON : 0));
+        ++count;
+    }
+
+    SensorData at(size_t i) const {
+        SensorData d;
+        d.timestamp = timestamp[i];
+        d.temperature = temperature[i];
+        d.humidity = humidity[i];
+        d.motion_detected = (flags[i] & SENSOR_FLAG_MOTION) ? 1 : 0;
+        d.button_pressed = (flags[i] & SENSOR_FLAG_BUTTON) ? 1 : 0;
+        return d;
+    }
+
+private:
+    friend class SensorBatchPool;
+    friend class BatchHandle;
+    std::atomic<uint32_t> refs_{0};
+    SensorBatchPool* pool_ = nullptr;
+};
+
+// Shared reference to a pooled batch; the batch goes back to its pool when
+// the last handle is dropped. Copying only touches an atomic counter.
+class BatchHandle {
+public:
+    BatchHandle() = default;
+    BatchHandle(const BatchHandle& other) : batch_(other.batch_) { retain(); }
+    BatchHandle(BatchHandle&& other) noexcept : batch_(other.batch_) { other.batch_ = nullptr; }
+    BatchHandle& operator=(BatchHandle other) noexcept {
+        std::swap(batch_, other.batch_);
+        return *this;
+    }
+    ~BatchHandle() { reset(); }
+
+    void reset();
+
+    SensorBatch* get() const { return batch_; }
+    SensorBatch* operator->() const { return batch_; }
+    SensorBatch& operator*() const { return *batch_; }
+    explicit operator bool() const { return batch_ != nullptr; }
+
+private:
+    friend class SensorBatchPool;
+    explicit BatchHandle(SensorBatch* batch) : batch_(batch) {}
+    void retain() {
+        if (batch_) batch_->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SensorBatch* batch_ = nullptr;
+};
+
+// Preallocated set of batches. acquire() returns an empty handle when every
+// batch is in use; callers treat that as back-pressure, never as a reason to
+// allocate.
+class SensorBatchPool {
+public:
+    explicit SensorBatchPool(size_t batches);
+    SensorBatchPool(const SensorBatchPool&) = delete;
+    SensorBatchPool& operator=(const SensorBatchPool&) = delete;
+
+    BatchHandle acquire();
+    size_t capacity() const { return capacity_; }
+    size_t available() const;
+
+private:
+    friend class BatchHandle;
+    void release(SensorBatch* batch);
+
+    size_t capacity_;
+    std::unique_ptr<SensorBatch[]> storage_;
+    mutable std::mutex m_;
+    std::vector<SensorBatch*> free_;
+};
+
+inline void BatchHandle::reset() {
+    if (batch_ && batch_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        batch_->pool_->release(batch_);
+    }
+    batch_ = nullptr;
+}
+
+#endif // SENSOR_BATCH_H
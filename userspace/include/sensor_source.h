@@ -0,0 +1,117 @@
+#ifndef SENSOR_SOURCE_H
+#define SENSOR_SOURCE_H
+
+#include "common.h"
+#include "sensor_batch.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// One reading as every source delivers it: fixed point, like the driver's
+// record (sensorhub_driver.h). SensorManager converts to float per batch.
+struct SensorSample {
+    uint64_t timestamp = 0;         // ns, CLOCK_MONOTONIC
+    int32_t temperature_milli = 0;  // milli-°C
+    int32_t humidity_milli = 0;     // milli-%RH
+    uint8_t flags = 0;              // SENSOR_FLAG_MOTION | SENSOR_FLAG_BUTTON
+};
+
+// Where SensorManager gets its samples from. read() never blocks: it returns
+// false when nothing is ready yet, and wait_fd() (if >= 0) becomes readable
+// once another read() may succeed.
+class SensorSource {
+public:
+    virtual ~SensorSource() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool read(SensorSample& sample) = 0;
+
+    virtual int wait_fd() const { return -1; }
+    virtual bool finished() const { return false; }
+    virtual const char* name() const = 0;
+};
+
+// The kernel driver's character device (/dev/sensorhub).
+class DeviceSensorSource : public SensorSource {
+public:
+    explicit DeviceSensorSource(std::string path);
+    ~DeviceSensorSource() override { close(); }
+
+    bool open() override;
+    void close() override;
+    bool read(SensorSample& sample) override;
+    int wait_fd() const override { return fd_; }  // driver implements poll()
+    const char* name() const override { return "device"; }
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+struct SyntheticConfig {
+    enum class Pattern { Steady, Burst };
+
+    double rate_hz = 1.0;           // average samples per second
+    Pattern pattern = Pattern::Steady;
+    uint32_t burst_size = 100;      // Burst: samples released at the same instant
+    double event_rate_hz = 0.0;     // motion/button edges per second
+    uint64_t max_samples = 0;       // 0 = unlimited
+    uint32_t seed = 1;
+};
+
+// Generates samples on the monotonic_ns() timeline at a configured rate.
+// Each sample is stamped with its scheduled time, so scheduling lag shows up
+// as latency downstream rather than being hidden.
+class SyntheticSensorSource : public SensorSource {
+public:
+    explicit SyntheticSensorSource(const SyntheticConfig& config);
+    ~SyntheticSensorSource() override { close(); }
+
+    bool open() override;
+    void close() override;
+    bool read(SensorSample& sample) override;
+    int wait_fd() const override { return timer_fd_; }
+    bool finished() const override;
+    const char* name() const override { return "synthetic"; }
+
+private:
+    uint64_t due_ns(uint64_t index) const;
+
+    SyntheticConfig config_;
+    int timer_fd_;
+    uint64_t start_ns_;
+    uint64_t emitted_;
+    uint64_t armed_for_;
+    int motion_;
+    std::minstd_rand rng_;
+};
+
+// Replays a capture file with one "timestamp_ns,temperature,humidity,motion,button"
+// record per line. Timestamps are rebased onto monotonic_ns() at open().
+class ReplaySensorSource : public SensorSource {
+public:
+    ReplaySensorSource(std::string path, bool realtime, bool loop = false);
+    ~ReplaySensorSource() override { close(); }
+
+    bool open() override;
+    void close() override;
+    bool read(SensorSample& sample) override;
+    int wait_fd() const override { return timer_fd_; }
+    bool finished() const override;
+    const char* name() const override { return "replay"; }
+
+private:
+    std::string path_;
+    bool realtime_;
+    bool loop_;
+    int timer_fd_;
+    std::vector<SensorSample> records_;
+    size_t next_;
+    uint64_t start_ns_;
+    uint64_t pass_offset_ns_;
+    uint64_t armed_for_;
+};
+
+#endif // SENSOR_SOURCE_H
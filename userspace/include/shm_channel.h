@@ -0,0 +1,106 @@
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+
+// C++ side of the shared-memory sample channel (layout in pirtos_shm.h):
+// the publisher SensorManager writes into, and a thin reader wrapper over
+// the C reader library.
+
+#include "pirtos_shm.h"
+#include "sensor_batch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static_assert(sizeof(pirtos_shm_header) == 128, "shm header layout changed");
+static_assert(sizeof(pirtos_shm_record) == PIRTOS_SHM_RECORD_V1_BYTES,
+              "shm record layout changed");
+static_assert(PIRTOS_SHM_FLAG_MOTION == SENSOR_FLAG_MOTION &&
+              PIRTOS_SHM_FLAG_BUTTON == SENSOR_FLAG_BUTTON &&
+              PIRTOS_SHM_FLAG_STALE == SENSOR_FLAG_STALE, "shm flags mirror SensorFlag");
+
+// Single writer. Publishing never blocks and never looks at readers beyond
+// one load of the waiter count (a futex wake only when someone sleeps).
+class ShmPublisher {
+public:
+    ShmPublisher() = default;
+    ~ShmPublisher() { close(); }
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+    // Creates ring `name` with `capacity` records (rounded up to a power of
+    // two), or takes over an existing one of the same size; readers mapped
+    // to a differently sized ring see it retired and reopen.
+    bool open(const std::string& name, uint32_t capacity);
+    // Unmaps; the ring stays in place with its last records for readers.
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    void publish(const SensorBatch& batch);
+
+    uint64_t published() const { return write_seq_; }
+    uint32_t capacity() const { return capacity_; }
+
+private:
+    pirtos_shm_header* header_ = nullptr;
+    uint8_t* slots_ = nullptr;
+    size_t map_bytes_ = 0;
+    uint32_t capacity_ = 0;
+    uint64_t write_seq_ = 0;
+};
+
+class ShmReader {
+public:
+    ShmReader() = default;
+    ~ShmReader() { close(); }
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+
+    // 0 or a negative errno, as pirtos_shm_open()
+    int open(const std::string& name) {
+        close();
+        int rc = pirtos_shm_open(&reader_, name.c_str());
+        open_ = rc == 0;
+        return rc;
+    }
+
+    void close() {
+        if (open_) pirtos_shm_close(&reader_);
+        open_ = false;
+    }
+
+    bool is_open() const { return open_; }
+    void seek_oldest() { pirtos_shm_seek_oldest(&reader_); }
+
+    int read(pirtos_shm_record* out, size_t max) { return pirtos_shm_read(&reader_, out, max); }
+
+    // Columns for the batch consumers; first_seq is the first record's
+    // sample sequence (later ones may skip if the reader was overrun).
+    int read(SensorBatch& out) {
+        int n = pirtos_shm_read(&reader_, records_, SensorBatch::kCapacity);
+        out.count = 0;
+        for (int i = 0; i < n; ++i) {
+            out.timestamp[i] = records_[i].timestamp_ns;
+            out.temperature[i] = records_[i].temperature;
+            out.humidity[i] = records_[i].humidity;
+            out.flags[i] = records_[i].flags;
+        }
+        if (n > 0) {
+            out.first_seq = records_[0].sample_seq;
+            out.count = static_cast<uint32_t>(n);
+        }
+        return n;
+    }
+
+    bool wait(int timeout_ms) { return pirtos_shm_wait(&reader_, timeout_ms) > 0; }
+
+    uint64_t overruns() const { return reader_.overruns; }
+    uint64_t next() const { return reader_.next; }
+
+private:
+    pirtos_shm_reader reader_{};
+    bool open_ = false;
+    pirtos_shm_record records_[SensorBatch::kCapacity];
+};
+
+#endif // SHM_CHANNEL_H
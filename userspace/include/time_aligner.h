@@ -0,0 +1,101 @@
+#ifndef TIME_ALIGNER_H
+#define TIME_ALIGNER_H
+
+#include "sensor_batch.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Independent timestamped streams fused by TimeAligner
+enum class AlignChannel : uint8_t { Temperature, Humidity, Motion, Button };
+
+struct TimeAlignerConfig {
+    enum class Fill {
+        Interpolate,  // linear between the observations around a grid point
+        Hold,         // last value carried forward
+    };
+
+    uint64_t period_ns = 1000000000ull;     // output grid spacing
+    // The watermark trails the newest observation by this much; a grid point
+    // is emitted once the watermark passes it. Observations older than the
+    // last emitted point are late (counted, applied only going forward).
+    // Buffering is bounded: keep lateness_ns under ~30 periods.
+    uint64_t lateness_ns = 500000000ull;
+    // Continuous channels whose observations around a grid point are further
+    // apart than this mark the record SENSOR_FLAG_STALE; 0 disables.
+    uint64_t max_gap_ns = 10000000000ull;
+    Fill temperature = Fill::Interpolate;
+    Fill humidity = Fill::Interpolate;
+    // Motion/button are states and always use Hold. A record also sets the
+    // flag if the state was active at any time since the previous grid
+    // point, so pulses shorter than period_ns still show.
+};
+
+// Time-alignment stage: keeps each channel as its own stream and emits fused
+// records on a common grid (multiples of period_ns on the sample timeline),
+// so every record is a coherent snapshot of all channels at one instant.
+// Output lags input by at most lateness_ns + period_ns.
+class TimeAligner {
+public:
+    explicit TimeAligner(const TimeAlignerConfig& config);
+
+    void push(AlignChannel channel, uint64_t timestamp, float value);
+
+    // Splits SensorManager records into channel observations. A record whose
+    // motion/button state changed came from an IRQ and re-reports the older
+    // temperature/humidity, so those only count if they changed too; any
+    // other record is a periodic sample of both.
+    void ingest(const SensorBatch& in);
+
+    // Appends grid records the watermark has passed; stops when `out` is
+    // full. Returns the number appended.
+    uint32_t drain(SensorBatch& out);
+
+    // End of input: emits every grid point the buffered data covers.
+    uint32_t flush(SensorBatch& out);
+
+    void reset();
+    uint64_t watermark() const;
+    uint64_t records_out() const { return records_out_; }
+    uint64_t late() const { return late_; }
+    uint64_t overflowed() const { return overflowed_; }
+
+private:
+    static constexpr int kChannels = 4;
+    static constexpr size_t kDepth = 64;  // per channel; ~2 per grid cell
+
+    struct Observation {
+        uint64_t timestamp;
+        float value;
+    };
+
+    struct Stream {
+        Observation obs[kDepth];
+        size_t count;
+    };
+
+    bool sample(int channel, uint64_t grid, float& value, bool& stale) const;
+    void emit(uint64_t grid, SensorBatch& out);
+    void prune(uint64_t grid);
+    uint32_t emit_until(uint64_t limit, SensorBatch& out);
+
+    TimeAlignerConfig config_;
+    TimeAlignerConfig::Fill fill_[kChannels];
+    Stream streams_[kChannels];
+
+    bool have_input_;
+    bool have_prev_;
+    uint64_t max_timestamp_;
+    uint64_t next_grid_;     // next grid point to emit
+    bool have_passed_;
+    uint64_t passed_;        // last grid point emitted or skipped
+    float prev_temperature_;
+    float prev_humidity_;
+    uint8_t prev_flags_;
+
+    uint64_t records_out_;
+    uint64_t late_;
+    uint64_t overflowed_;
+};
+
+#endif // TIME_ALIGNER_H
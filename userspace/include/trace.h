@@ -0,0 +1,110 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Pipeline trace points exported as Chrome Trace / Perfetto JSON.
+//
+// Each thread records into its own lock-free buffer, freed by the writer after
+// the thread exits. With tracing off a trace point costs one relaxed load and
+// a branch once inlined: under 1 ns in a Release build, ~16 ns unoptimized
+// (no CMAKE_BUILD_TYPE), as measured by pirtos_bench --filter trace. Event
+// names must be string literals (only the pointer is stored). `seq` is the
+// sample sequence id, so one sample (or batch, by its first_seq) can be
+// followed across threads.
+//
+//   trace::set_enabled(true);
+//   { TRACE_SCOPE("logger.log_batch", batch.first_seq); ... }
+//   trace::TraceWriter w; w.open("trace.json"); w.flush(); w.close();
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace trace {
+
+enum class Phase : char {
+    Begin = 'B',
+    End = 'E',
+    Instant = 'i',
+    FlowStart = 's',   // flow arrows link slices that share a seq
+    FlowStep = 't',
+    FlowEnd = 'f',
+};
+
+struct Event {
+    uint64_t ts_ns;
+    uint64_t seq;
+    const char* name;
+    Phase phase;
+};
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+void set_enabled(bool on);
+
+// Names the calling thread in the exported timeline (string literal).
+void set_thread_name(const char* name);
+
+// Slow path; callers check enabled() first.
+void record(const char* name, Phase phase, uint64_t seq);
+
+inline void instant(const char* name, uint64_t seq) {
+    if (enabled()) record(name, Phase::Instant, seq);
+}
+inline void flow(const char* name, Phase phase, uint64_t seq) {
+    if (enabled()) record(name, phase, seq);
+}
+
+class Scope {
+public:
+    Scope(const char* name, uint64_t seq)
+        : name_(name), seq_(seq), active_(enabled()) {
+        if (active_) record(name_, Phase::Begin, seq_);
+    }
+    ~Scope() {
+        if (active_) record(name_, Phase::End, seq_);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t seq_;
+    bool active_;
+};
+
+// Events dropped because a thread's buffer was full when it recorded.
+uint64_t dropped();
+
+// Per-thread buffers still allocated: live recording threads plus exited
+// ones the writer has not drained yet.
+size_t thread_buffers();
+
+// Drains every thread's buffer into a Chrome Trace JSON file. Call flush()
+// periodically to stream, or once before close() to dump.
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    ~TraceWriter() { close(); }
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool open(const std::string& path);
+    size_t flush();
+    void close();
+    bool is_open() const { return file_ != nullptr; }
+
+private:
+    std::FILE* file_ = nullptr;
+    bool first_ = true;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name, seq) ::trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name, seq)
+
+#endif // TRACE_H
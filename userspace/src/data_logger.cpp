@@ -0,0 +1,49 @@
+#include "data_logger.h"
+#include "trace.h"
+#include <iostream>
+
+DataLogger::DataLogger(std::string path) : path_(std::move(path)) {}
+
+void DataLogger::log_data(const SensorData& data) {
+    // Stub: write to stdout; replace with SQLite/file logging as needed.
+    std::cout << "[LOG] (" << path_ << ") "
+              << "temp=" << data.temperature << "C "
+              << "hum=" << data.humidity << "% "
+              << "motion=" << data.motion_detected << " "
+              << "button=" << data.button_pressed << " "
+              << "ts=" << data.timestamp
+              << std::endl;
+}
+
+void DataLogger::log_batch(const SensorBatch& batch) {
+    TRACE_SCOPE("logger.log_batch", batch.first_seq);
+    trace::flow("sample", trace::Phase::FlowStep, batch.first_seq);
+    for (uint32_t i = 0; i < batch.count; ++i) {
+        std::cout << "[LOG] (" << path_ << ") "
+                  << "temp=" << batch.temperature[i] << "C "
+                  << "hum=" << batch.humidity[i] << "% "
+                  << "motion=" << ((batch.flags[i] & SENSOR_FLAG_MOTION) ? 1 : 0) << " "
+                  << "button=" << ((batch.flags[i] & SENSOR_FLAG_BUTTON) ? 1 : 0) << " "
+                  << "ts=" << batch.timestamp[i]
+                  << '\n';
+    }
+    std::cout.flush();
+}
+
+void DataLogger::log_aggregates(uint64_t window_start_ns, const gateway::HubAggregate* aggs,
+                                size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const gateway::HubAggregate& a = aggs[i];
+        std::cout << "[LOG] (" << path_ << ") "
+                  << "window=" << window_start_ns << " "
+                  << "hub=" << a.hub_id << " "
+                  << "n=" << a.count << " "
+                  << "temp=" << a.temp_min << "/" << a.temp_mean << "/" << a.temp_max << "C "
+                  << "hum=" << a.hum_min << "/" << a.hum_mean << "/" << a.hum_max << "% "
+                  << "motion=" << a.motion_events << " "
+                  << "button=" << a.button_events << " "
+                  << "gaps=" << a.gap_samples
+                  << '\n';
+    }
+    std::cout.flush();
+}
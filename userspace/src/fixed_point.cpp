@@ -0,0 +1,39 @@
+#include "fixed_point.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FIXED_POINT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FIXED_POINT_SSE2 1
+#endif
+
+namespace fixed {
+
+void milli_to_float_scalar(const int32_t* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = from_milli(in[i]);
+}
+
+void milli_to_float(const int32_t* in, float* out, size_t n) {
+    size_t i = 0;
+#if defined(FIXED_POINT_NEON)
+    const float32x4_t scale = vdupq_n_f32(kFromMilli);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vcvtq_f32_s32(vld1q_s32(in + i));
+        float32x4_t b = vcvtq_f32_s32(vld1q_s32(in + i + 4));
+        vst1q_f32(out + i, vmulq_f32(a, scale));
+        vst1q_f32(out + i + 4, vmulq_f32(b, scale));
+    }
+#elif defined(FIXED_POINT_SSE2)
+    const __m128 scale = _mm_set1_ps(kFromMilli);
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+#endif
+    for (; i < n; ++i) out[i] = from_milli(in[i]);
+}
+
+} // namespace fixed
@@ -0,0 +1,607 @@
+#include "gateway.h"
+#include "common.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+using gateway::FrameHeader;
+using gateway::HubAggregate;
+
+namespace {
+constexpr auto kStopCheck = std::chrono::milliseconds(100);
+constexpr size_t kTcpBufferBytes = 16 * gateway::kFrameMaxBytes;
+constexpr int kOpenWindows = 4;  // per hub
+}
+
+// ---------------------------------------------------------------------------
+// Frames in flight from the receive thread to the shards
+
+struct Gateway::Frame {
+    size_t len;
+    uint64_t recv_ns;
+    uint8_t data[gateway::kFrameMaxBytes];
+};
+
+class Gateway::FramePool {
+public:
+    explicit FramePool(size_t n) : storage_(new Frame[n]) {
+        free_.reserve(n);
+        for (size_t i = 0; i < n; ++i) free_.push_back(&storage_[i]);
+    }
+
+    Frame* acquire() {
+        std::lock_guard<std::mutex> lock(m_);
+        if (free_.empty()) return nullptr;
+        Frame* f = free_.back();
+        free_.pop_back();
+        return f;
+    }
+
+    void release(Frame* f) {
+        std::lock_guard<std::mutex> lock(m_);
+        free_.push_back(f);
+    }
+
+private:
+    std::unique_ptr<Frame[]> storage_;
+    std::mutex m_;
+    std::vector<Frame*> free_;
+};
+
+// ---------------------------------------------------------------------------
+// Shard: owns every hub with hub_id % shards == index
+
+class Gateway::Shard {
+public:
+    Shard(const GatewayConfig& config, FramePool& pool, size_t inbox_capacity)
+        : config_(config), pool_(pool) {
+        inbox_.reserve(inbox_capacity);
+        local_.reserve(inbox_capacity);
+    }
+
+    void start(int cpu) {
+        thread_ = std::thread(&Shard::run, this);
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(thread_.native_handle(), sizeof(set), &set);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(in_m_);
+            stopping_ = true;
+        }
+        in_cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void push(Frame* f) {
+        {
+            std::lock_guard<std::mutex> lock(in_m_);
+            inbox_.push_back(f);  // capacity covers the whole pool
+        }
+        in_cv_.notify_one();
+    }
+
+    void take_output(std::vector<HubAggregate>& out) {
+        std::lock_guard<std::mutex> lock(out_m_);
+        out.insert(out.end(), outbox_.begin(), outbox_.end());
+        outbox_.clear();
+    }
+
+    std::vector<HubStats> hub_stats() const {
+        std::vector<HubStats> out;
+        for (auto& kv : hubs_) out.push_back(kv.second.stats);
+        return out;
+    }
+
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> gap_samples{0};
+    std::atomic<uint64_t> out_of_order{0};
+    std::atomic<uint64_t> late_samples{0};
+    std::atomic<uint64_t> resyncs{0};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<uint64_t> hubs{0};
+
+private:
+    struct Window {
+        bool open = false;
+        uint64_t index = 0;
+        uint32_t count = 0;
+        double temp_sum = 0.0, hum_sum = 0.0;
+        HubAggregate agg;
+    };
+
+    struct Hub {
+        HubStats stats;
+        bool have_seq = false;
+        bool have_offset = false;
+        bool have_closed = false;
+        uint64_t max_ts = 0;         // gateway clock
+        uint64_t last_recv_ns = 0;
+        uint64_t closed_through = 0; // newest closed window index
+        uint8_t prev_flags = 0;
+        Window windows[kOpenWindows];
+    };
+
+    void run() {
+        trace::set_thread_name("gateway_shard");
+        while (true) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(in_m_);
+                in_cv_.wait_for(lock, kStopCheck, [&] { return !inbox_.empty() || stopping_; });
+                local_.swap(inbox_);
+                stopping = stopping_;
+            }
+            for (Frame* f : local_) {
+                process(*f);
+                pool_.release(f);
+            }
+            local_.clear();
+
+            uint64_t now = monotonic_ns();
+            for (auto& kv : hubs_) {
+                if (stopping || now - kv.second.last_recv_ns >= config_.idle_ns) {
+                    close_until(kv.second, UINT64_MAX);
+                }
+            }
+            if (stopping) {
+                std::lock_guard<std::mutex> lock(in_m_);
+                if (inbox_.empty()) break;
+            }
+        }
+    }
+
+    void process(const Frame& f) {
+        FrameHeader h;
+        if (!gateway::decode_frame(f.data, f.len, h, batch_)) {
+            ++malformed;
+            return;
+        }
+        auto it = hubs_.find(h.hub_id);
+        if (it == hubs_.end()) {
+            it = hubs_.emplace(h.hub_id, Hub{}).first;
+            it->second.stats.hub_id = h.hub_id;
+            ++hubs;
+        }
+        Hub& hub = it->second;
+        hub.last_recv_ns = f.recv_ns;
+        ++hub.stats.frames;
+        ++frames;
+
+        // Sequence: a forward jump is a gap; anything behind is a duplicate
+        // or reordered frame whose place was already counted as a gap.
+        // A new epoch is a new stream (reconnect, restart): it starts over.
+        uint32_t skip = 0;
+        uint64_t gap = 0;
+        if (hub.have_seq && h.epoch != hub.stats.epoch) {
+            resync(hub);
+            ++hub.stats.resyncs;
+            ++resyncs;
+        }
+        if (!hub.have_seq) {
+            hub.have_seq = true;
+            hub.stats.epoch = h.epoch;
+            hub.stats.next_seq = h.first_seq;
+        }
+        if (h.first_seq + h.count <= hub.stats.next_seq) {
+            ++hub.stats.out_of_order;
+            ++out_of_order;
+            return;
+        }
+        if (h.first_seq < hub.stats.next_seq) {
+            skip = static_cast<uint32_t>(hub.stats.next_seq - h.first_seq);
+        } else if (h.first_seq > hub.stats.next_seq) {
+            gap = h.first_seq - hub.stats.next_seq;
+            hub.stats.gap_samples += gap;
+            ++hub.stats.gap_events;
+            gap_samples += gap;
+        }
+        hub.stats.next_seq = h.first_seq + h.count;
+
+        // Clock mapping: the smallest receive - send difference seen so far
+        int64_t offset = static_cast<int64_t>(f.recv_ns) - static_cast<int64_t>(h.sent_ns);
+        if (!hub.have_offset || offset < hub.stats.clock_offset_ns) {
+            hub.stats.clock_offset_ns = offset;
+            hub.have_offset = true;
+        }
+
+        for (uint32_t i = skip; i < batch_.count; ++i) {
+            int64_t ts = static_cast<int64_t>(batch_.timestamp[i]) + hub.stats.clock_offset_ns;
+            add_sample(hub, ts > 0 ? static_cast<uint64_t>(ts) : 0, i, i == skip ? gap : 0);
+        }
+        uint32_t n = batch_.count - skip;
+        hub.stats.samples += n;
+        samples += n;
+
+        if (hub.max_ts > config_.lateness_ns) {
+            uint64_t watermark = hub.max_ts - config_.lateness_ns;
+            close_until(hub, watermark / config_.window_ns);
+        }
+    }
+
+    // A rebooted hub's clock restarts near zero, so nothing learned from
+    // the old stream applies: its open windows are released and the clock
+    // mapping and window bookkeeping start again from the next frame.
+    void resync(Hub& hub) {
+        close_until(hub, UINT64_MAX);
+        hub.have_seq = false;
+        hub.have_offset = false;
+        hub.have_closed = false;
+        hub.max_ts = 0;
+        hub.closed_through = 0;
+        hub.prev_flags = 0;
+    }
+
+    void add_sample(Hub& hub, uint64_t ts, uint32_t i, uint64_t gap) {
+        hub.max_ts = std::max(hub.max_ts, ts);
+        uint64_t index = ts / config_.window_ns;
+        if (hub.have_closed && index <= hub.closed_through) {
+            ++hub.stats.late_samples;
+            ++late_samples;
+            return;
+        }
+
+        Window* w = nullptr;
+        Window* oldest = nullptr;
+        for (Window& c : hub.windows) {
+            if (c.open && c.index == index) w = &c;
+            if (c.open && (!oldest || c.index < oldest->index)) oldest = &c;
+        }
+        if (!w) {
+            for (Window& c : hub.windows) {
+                if (!c.open) w = &c;
+            }
+            if (!w) {
+                // More distinct windows in flight than slots: close early
+                close_until(hub, oldest->index + 1);
+                if (index <= hub.closed_through) {
+                    ++hub.stats.late_samples;
+                    ++late_samples;
+                    return;
+                }
+                w = oldest;
+            }
+            *w = Window{};
+            w->open = true;
+            w->index = index;
+            w->agg.hub_id = hub.stats.hub_id;
+            w->agg.window_start_ns = index * config_.window_ns;
+        }
+
+        float t = batch_.temperature[i], h = batch_.humidity[i];
+        uint8_t flags = batch_.flags[i];
+        HubAggregate& a = w->agg;
+        if (w->count == 0) {
+            a.temp_min = a.temp_max = t;
+            a.hum_min = a.hum_max = h;
+        }
+        a.temp_min = std::min(a.temp_min, t);
+        a.temp_max = std::max(a.temp_max, t);
+        a.hum_min = std::min(a.hum_min, h);
+        a.hum_max = std::max(a.hum_max, h);
+        w->temp_sum += t;
+        w->hum_sum += h;
+        ++w->count;
+        uint8_t rising = flags & ~hub.prev_flags;
+        if (rising & SENSOR_FLAG_MOTION) ++a.motion_events;
+        if (rising & SENSOR_FLAG_BUTTON) ++a.button_events;
+        hub.prev_flags = flags;
+        a.gap_samples += static_cast<uint32_t>(gap);
+    }
+
+    // Closes windows with index < `end_index` in time order
+    void close_until(Hub& hub, uint64_t end_index) {
+        while (true) {
+            Window* next = nullptr;
+            for (Window& c : hub.windows) {
+                if (c.open && c.index < end_index && (!next || c.index < next->index)) next = &c;
+            }
+            if (!next) return;
+            HubAggregate& a = next->agg;
+            a.count = next->count;
+            a.temp_mean = static_cast<float>(next->temp_sum / next->count);
+            a.hum_mean = static_cast<float>(next->hum_sum / next->count);
+            next->open = false;
+            hub.closed_through = hub.have_closed ? std::max(hub.closed_through, next->index)
+                                                 : next->index;
+            hub.have_closed = true;
+            std::lock_guard<std::mutex> lock(out_m_);
+            outbox_.push_back(a);
+        }
+    }
+
+    const GatewayConfig& config_;
+    FramePool& pool_;
+    std::thread thread_;
+    std::unordered_map<uint32_t, Hub> hubs_;
+    SensorBatch batch_;  // decode scratch
+
+    std::mutex in_m_;
+    std::condition_variable in_cv_;
+    std::vector<Frame*> inbox_;
+    std::vector<Frame*> local_;
+    bool stopping_ = false;
+
+    std::mutex out_m_;
+    std::vector<HubAggregate> outbox_;
+};
+
+// ---------------------------------------------------------------------------
+
+Gateway::Gateway(const GatewayConfig& config) : config_(config) {
+    if (config_.window_ns == 0) config_.window_ns = 1;
+    if (config_.shards == 0) {
+        config_.shards = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+Gateway::~Gateway() { stop(); }
+
+namespace {
+int open_socket(int type, uint16_t port) {
+    int fd = ::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (type == SOCK_DGRAM) {
+        // Absorb bursts from many hubs while the receive thread catches up
+        int rcvbuf = 4 << 20;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        (type == SOCK_STREAM && ::listen(fd, 1024) < 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+}
+
+bool Gateway::start(Sink sink) {
+    sink_ = std::move(sink);
+    if (config_.udp_port) {
+        udp_fd_ = open_socket(SOCK_DGRAM, config_.udp_port);
+        if (udp_fd_ < 0) {
+            std::cerr << "Gateway: cannot bind UDP port " << config_.udp_port << ": "
+                      << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    if (config_.tcp_port) {
+        tcp_fd_ = open_socket(SOCK_STREAM, config_.tcp_port);
+        if (tcp_fd_ < 0) {
+            std::cerr << "Gateway: cannot listen on TCP port " << config_.tcp_port << ": "
+                      << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+    }
+
+    frames_ = std::make_unique<FramePool>(config_.frame_pool);
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < config_.shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(config_, *frames_, config_.frame_pool));
+        shards_.back()->start(config_.pin_shards ? static_cast<int>(i % cores) : -1);
+    }
+
+    running_ = true;
+    receiver_ = std::thread(&Gateway::receive_thread, this);
+    std::cout << "Gateway listening (udp=" << config_.udp_port << ", tcp=" << config_.tcp_port
+              << ", shards=" << config_.shards << ")" << std::endl;
+    return true;
+}
+
+void Gateway::stop() {
+    running_ = false;
+    if (receiver_.joinable()) receiver_.join();
+    for (auto& shard : shards_) shard->stop();
+    if (udp_fd_ >= 0) ::close(udp_fd_);
+    if (tcp_fd_ >= 0) ::close(tcp_fd_);
+    udp_fd_ = tcp_fd_ = -1;
+}
+
+void Gateway::receive_thread() {
+    trace::set_thread_name("gateway_recv");
+    Reactor reactor;
+    if (udp_fd_ >= 0) reactor.spawn(udp_loop(reactor));
+    if (tcp_fd_ >= 0) reactor.spawn(tcp_accept_loop(reactor));
+    reactor.run();
+}
+
+void Gateway::route(Frame* frame, uint32_t hub_id) {
+    shards_[hub_id % shards_.size()]->push(frame);
+}
+
+void Gateway::dispatch(const uint8_t* data, size_t len, uint32_t hub_id, uint64_t recv_ns) {
+    Frame* f = frames_->acquire();
+    if (!f) {
+        ++frames_dropped_;
+        return;
+    }
+    std::memcpy(f->data, data, len);
+    f->len = len;
+    f->recv_ns = recv_ns;
+    route(f, hub_id);
+}
+
+AsyncTask<> Gateway::udp_loop(Reactor& reactor) {
+    uint8_t scratch[gateway::kFrameMaxBytes + 1];
+    while (running_) {
+        if (co_await reactor.poll(udp_fd_, POLLIN, kStopCheck) <= 0) continue;
+        // Drain every queued datagram per wakeup, straight into pooled frames
+        while (true) {
+            Frame* f = frames_->acquire();
+            uint8_t* dst = f ? f->data : scratch;
+            ssize_t n = ::recv(udp_fd_, dst, gateway::kFrameMaxBytes + (f ? 0 : 1), MSG_DONTWAIT);
+            if (n < 0) {
+                if (f) frames_->release(f);
+                break;
+            }
+            if (!f) {
+                ++frames_dropped_;
+                continue;
+            }
+            FrameHeader h;
+            if (!gateway::decode_header(dst, n, h) ||
+                static_cast<size_t>(n) != gateway::frame_bytes(h.count)) {
+                ++malformed_;
+                frames_->release(f);
+                continue;
+            }
+            f->len = static_cast<size_t>(n);
+            f->recv_ns = monotonic_ns();
+            route(f, h.hub_id);
+        }
+    }
+}
+
+AsyncTask<> Gateway::tcp_accept_loop(Reactor& reactor) {
+    uint32_t generation = tcp_generation_;
+    while (running_) {
+        if (generation != tcp_generation_) {
+            generation = tcp_generation_;
+            ::close(tcp_fd_);
+            tcp_fd_ = open_socket(SOCK_STREAM, config_.tcp_port);
+            if (tcp_fd_ < 0) {
+                std::cerr << "Gateway: cannot reopen TCP port " << config_.tcp_port << ": "
+                          << std::strerror(errno) << std::endl;
+                co_return;
+            }
+        }
+        if (co_await reactor.poll(tcp_fd_, POLLIN, kStopCheck) <= 0) continue;
+        int fd;
+        while ((fd = ::accept4(tcp_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            reactor.spawn(tcp_connection(reactor, fd));
+        }
+    }
+}
+
+AsyncTask<> Gateway::tcp_connection(Reactor& reactor, int fd) {
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[kTcpBufferBytes]);
+    size_t have = 0;
+    bool open = true;
+    const uint32_t generation = tcp_generation_;
+    while (running_ && open && generation == tcp_generation_) {
+        if (co_await reactor.poll(fd, POLLIN, kStopCheck) <= 0) continue;
+        ssize_t n = ::recv(fd, buf.get() + have, kTcpBufferBytes - have, MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) break;
+        if (n < 0) continue;
+        have += static_cast<size_t>(n);
+
+        uint64_t now = monotonic_ns();
+        size_t off = 0;
+        while (have - off >= gateway::kFrameHeaderBytes) {
+            FrameHeader h;
+            if (!gateway::decode_header(buf.get() + off, have - off, h)) {
+                // Lost framing; the hub reconnects and resynchronizes
+                ++malformed_;
+                open = false;
+                break;
+            }
+            size_t len = gateway::frame_bytes(h.count);
+            if (have - off < len) break;
+            dispatch(buf.get() + off, len, h.hub_id, now);
+            off += len;
+        }
+        std::memmove(buf.get(), buf.get() + off, have - off);
+        have -= off;
+    }
+    ::close(fd);
+}
+
+// ---------------------------------------------------------------------------
+// Merge
+
+size_t Gateway::release(uint64_t limit_ns, bool all) {
+    for (auto& shard : shards_) shard->take_output(collected_);
+    if (!collected_.empty()) {
+        pending_.insert(pending_.end(), collected_.begin(), collected_.end());
+        collected_.clear();
+        std::sort(pending_.begin(), pending_.end(), [](const HubAggregate& a, const HubAggregate& b) {
+            return a.window_start_ns != b.window_start_ns ? a.window_start_ns < b.window_start_ns
+                                                          : a.hub_id < b.hub_id;
+        });
+    }
+
+    const uint64_t hold = config_.window_ns + config_.lateness_ns + config_.merge_delay_ns;
+    size_t windows = 0;
+    size_t i = 0;
+    while (i < pending_.size()) {
+        uint64_t start = pending_[i].window_start_ns;
+        if (!all && start + hold > limit_ns) break;
+        size_t j = i;
+        while (j < pending_.size() && pending_[j].window_start_ns == start) ++j;
+
+        if (released_any_ && start <= released_through_) {
+            late_aggregates_ += j - i;
+        } else {
+            ++windows_released_;
+            released_through_ = start;
+            released_any_ = true;
+        }
+        aggregates_ += j - i;
+        if (sink_) sink_(start, pending_.data() + i, j - i);
+        ++windows;
+        i = j;
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + i);
+    return windows;
+}
+
+size_t Gateway::poll(uint64_t now_ns) { return release(now_ns, false); }
+
+size_t Gateway::flush() { return release(0, true); }
+
+GatewayStats Gateway::stats() const {
+    GatewayStats s;
+    for (auto& shard : shards_) {
+        s.frames += shard->frames;
+        s.samples += shard->samples;
+        s.gap_samples += shard->gap_samples;
+        s.out_of_order += shard->out_of_order;
+        s.late_samples += shard->late_samples;
+        s.resyncs += shard->resyncs;
+        s.malformed += shard->malformed;
+        s.hubs += shard->hubs;
+        s.frames_per_shard.push_back(shard->frames);
+    }
+    s.malformed += malformed_;
+    s.frames_dropped = frames_dropped_;
+    s.windows_released = windows_released_;
+    s.aggregates = aggregates_;
+    s.late_aggregates = late_aggregates_;
+    return s;
+}
+
+std::vector<HubStats> Gateway::hub_stats() const {
+    std::vector<HubStats> out;
+    for (auto& shard : shards_) {
+        auto hubs = shard->hub_stats();
+        out.insert(out.end(), hubs.begin(), hubs.end());
+    }
+    std::sort(out.begin(), out.end(),
+              [](const HubStats& a, const HubStats& b) { return a.hub_id < b.hub_id; });
+    return out;
+}
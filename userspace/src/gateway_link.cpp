@@ -0,0 +1,234 @@
+#include "gateway_link.h"
+#include "common.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool GatewayUplink::connect(const std::string& host, uint16_t port, uint32_t hub_id, bool tcp) {
+    close();
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = tcp ? SOCK_STREAM : SOCK_DGRAM;
+    // An address literal never touches the resolver; a name is looked up
+    // once here (blocking on DNS only) and reconnects reuse the result
+    hints.ai_flags = AI_NUMERICHOST;
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    int rc = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &res);
+    if (rc == EAI_NONAME) {
+        hints.ai_flags = 0;
+        rc = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &res);
+    }
+    if (rc != 0) {
+        std::cerr << "Gateway uplink: cannot resolve " << host << ": " << gai_strerror(rc)
+                  << std::endl;
+        return false;
+    }
+    std::memcpy(&addr_, res->ai_addr, res->ai_addrlen);
+    addr_len_ = res->ai_addrlen;
+    ::freeaddrinfo(res);
+
+    tcp_ = tcp;
+    hub_id_ = hub_id;
+    epoch_ = std::random_device{}();
+    next_seq_ = 0;
+    was_up_ = false;
+    reconnects_ = 0;
+    if (tcp) {
+        // Same nonblocking path as every reconnect: an unreachable gateway
+        // must not hold up hub startup for the kernel's SYN retries
+        if (!out_) out_.reset(new uint8_t[kOutboundBytes]);
+        backoff_ns_ = kBackoffMinNs;
+        retry_at_ns_ = 0;
+        reconnect();
+        return true;
+    }
+
+    // UDP connect() only fixes the peer address; it never waits
+    fd_ = ::socket(addr_.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<const sockaddr*>(&addr_), addr_len_) < 0) {
+        std::cerr << "Gateway uplink: cannot connect to " << host << ":" << port << ": "
+                  << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool GatewayUplink::wait_connected(int timeout_ms) {
+    if (!tcp_) return fd_ >= 0;
+    check_peer();
+    const uint64_t deadline = monotonic_ns() + static_cast<uint64_t>(timeout_ms) * 1000000ull;
+    while (!connected() && addr_len_ && monotonic_ns() < deadline) {
+        if (connecting_) {
+            pollfd pfd{fd_, POLLOUT, 0};
+            ::poll(&pfd, 1, 10);
+        } else {
+            ::usleep(10000);
+        }
+        reconnect();
+    }
+    return connected();
+}
+
+void GatewayUplink::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    connecting_ = false;
+    addr_len_ = 0;
+    out_head_ = out_len_ = 0;
+}
+
+void GatewayUplink::link_up() {
+    int one = 1;
+    ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connecting_ = false;
+    backoff_ns_ = kBackoffMinNs;
+    ++epoch_;
+    if (was_up_) ++reconnects_;
+    was_up_ = true;
+}
+
+// Bytes still queued belong to a stream that is gone, as do those in the
+// kernel's socket buffer
+void GatewayUplink::link_down() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    connecting_ = false;
+    out_head_ = out_len_ = 0;
+    retry_at_ns_ = monotonic_ns() + backoff_ns_;
+    backoff_ns_ = std::min(backoff_ns_ * 2, kBackoffMaxNs);
+}
+
+// Advances a nonblocking reconnect; true once the stream is up
+bool GatewayUplink::reconnect() {
+    if (connecting_) {
+        pollfd pfd{fd_, POLLOUT, 0};
+        if (::poll(&pfd, 1, 0) == 0) return false;
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            link_down();
+            return false;
+        }
+        link_up();
+        return true;
+    }
+    if (monotonic_ns() < retry_at_ns_) return false;
+    fd_ = ::socket(addr_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        link_down();
+        return false;
+    }
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr_), addr_len_) == 0) {
+        link_up();
+        return true;
+    }
+    if (errno != EINPROGRESS) {
+        link_down();
+        return false;
+    }
+    connecting_ = true;
+    return false;
+}
+
+// The gateway never writes to hubs, so a readable stream means FIN or RST.
+// Checked before each send: otherwise a restarted gateway goes unnoticed
+// until a write fails, one or two frames later.
+bool GatewayUplink::peer_closed() const {
+    pollfd pfd{fd_, POLLIN | POLLRDHUP, 0};
+    return ::poll(&pfd, 1, 0) > 0 && pfd.revents != 0;
+}
+
+void GatewayUplink::check_peer() {
+    if (tcp_ && connected() && peer_closed()) {
+        // A link that was up gets one immediate retry; backoff covers failures
+        link_down();
+        retry_at_ns_ = 0;
+    }
+}
+
+void GatewayUplink::queue(const uint8_t* data, size_t len) {
+    if (out_head_ + out_len_ + len > kOutboundBytes) {
+        std::memmove(out_.get(), out_.get() + out_head_, out_len_);
+        out_head_ = 0;
+    }
+    std::memcpy(out_.get() + out_head_ + out_len_, data, len);
+    out_len_ += len;
+}
+
+bool GatewayUplink::flush() {
+    while (out_len_ > 0 && connected()) {
+        ssize_t n = ::send(fd_, out_.get() + out_head_, out_len_, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            // A broken stream can't be resumed mid-frame: start a new one
+            if (errno != EAGAIN && errno != EWOULDBLOCK) link_down();
+            break;
+        }
+        out_head_ += static_cast<size_t>(n);
+        out_len_ -= static_cast<size_t>(n);
+    }
+    if (out_len_ == 0) out_head_ = 0;
+    return out_len_ == 0;
+}
+
+bool GatewayUplink::send_frame(size_t len) {
+    if (!tcp_) {
+        ssize_t n = ::send(fd_, buf_, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        return n == static_cast<ssize_t>(len);
+    }
+    if (!connected()) return false;
+    // Queued bytes go first so frames stay in order on the stream
+    if (!flush()) {
+        if (!connected() || out_len_ + len > kOutboundBytes) return false;
+        queue(buf_, len);
+        return true;
+    }
+    if (!connected()) return false;
+    ssize_t n = ::send(fd_, buf_, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            link_down();
+            return false;
+        }
+        n = 0;
+    }
+    // Whatever the kernel didn't take of this frame must follow it next
+    if (static_cast<size_t>(n) < len) queue(buf_ + n, len - static_cast<size_t>(n));
+    return true;
+}
+
+bool GatewayUplink::send(const SensorBatch& batch, uint64_t sent_ns) {
+    if (!addr_len_) return false;
+    check_peer();
+    if (tcp_ && !connected()) reconnect();
+    bool ok = true;
+    for (uint32_t from = 0; from < batch.count;) {
+        uint16_t n = static_cast<uint16_t>(
+            std::min<uint32_t>(batch.count - from, gateway::kFrameMaxSamples));
+        size_t len = gateway::encode_frame(hub_id_, epoch_, next_seq_, sent_ns, batch, from, n, buf_);
+        next_seq_ += n;
+        if (send_frame(len)) {
+            ++frames_sent_;
+        } else {
+            ++frames_dropped_;
+            ok = false;
+        }
+        from += n;
+    }
+    return ok;
+}
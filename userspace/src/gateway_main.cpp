@@ -0,0 +1,415 @@
+// pirtos_gateway: site aggregator for many hubs. Hubs push reported batches
+// (GATEWAY_UPLINK in config.h); the gateway forwards one aggregate per hub
+// per window to the DataLogger and upstream via NetworkManager.
+//
+//   pirtos_gateway --udp 7878 --tcp 7878
+//   pirtos_gateway --sim-hubs 300 --sim-rate 20 --duration 10
+//   pirtos_gateway --sim-hubs 500 --sim-loss 0.01 --sim-tcp --shards 4
+//   pirtos_gateway --sim-hubs 200 --sim-tcp --sim-restart
+//   pirtos_gateway --sim-hubs 200 --sim-reboot
+//
+// With --sim-hubs the same process also runs simulated hubs on localhost and
+// checks that every sample each hub sent is accounted for as received or as
+// a detected gap.
+
+#include "gateway.h"
+#include "data_logger.h"
+#include "network_manager.h"
+#include "common.h"
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> g_running{true};
+
+void signal_handler(int) { g_running = false; }
+
+struct Options {
+    GatewayConfig gateway;
+    double duration_s = 0.0;  // 0 = until SIGINT (sim default: 10)
+    bool verbose = false;
+
+    unsigned sim_hubs = 0;
+    unsigned sim_threads = 4;
+    double sim_rate_hz = 10.0;  // samples per second per hub
+    unsigned sim_batch = 10;
+    double sim_loss = 0.0;      // fraction of frames dropped before sending
+    bool sim_tcp = false;
+    bool sim_restart = false;   // restart the TCP listener halfway through
+    bool sim_reboot = false;    // reboot every hub (clock, sequence, link) halfway
+};
+
+// Swallows sink output while still paying the formatting cost.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+void usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " [options]\n"
+        << "  --udp PORT         UDP ingest port, 0 disables (default 7878)\n"
+        << "  --tcp PORT         TCP ingest port, 0 disables (default 7878)\n"
+        << "  --shards N         parse/aggregate threads (default: one per core)\n"
+        << "  --no-pin           do not pin shard threads to cores\n"
+        << "  --window-ms MS     aggregate window (default 1000)\n"
+        << "  --lateness-ms MS   per-hub reordering allowance (default 3000)\n"
+        << "  --duration S       stop after S seconds (default: until SIGINT)\n"
+        << "  --verbose          print forwarded aggregates\n"
+        << "  --sim-hubs N       run N simulated hubs against this gateway\n"
+        << "  --sim-threads N    sender threads (default 4)\n"
+        << "  --sim-rate HZ      samples per second per hub (default 10)\n"
+        << "  --sim-batch N      samples per frame (default 10)\n"
+        << "  --sim-loss P       drop fraction P of frames before sending\n"
+        << "  --sim-tcp          simulated hubs connect over TCP\n"
+        << "  --sim-restart      drop all TCP connections halfway; hubs must reconnect\n"
+        << "  --sim-reboot       reboot every hub halfway: its clock restarts near zero\n";
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--udp") opt.gateway.udp_port = static_cast<uint16_t>(std::atoi(value()));
+        else if (arg == "--tcp") opt.gateway.tcp_port = static_cast<uint16_t>(std::atoi(value()));
+        else if (arg == "--shards") opt.gateway.shards = std::strtoul(value(), nullptr, 10);
+        else if (arg == "--no-pin") opt.gateway.pin_shards = false;
+        else if (arg == "--window-ms") opt.gateway.window_ns = std::strtoull(value(), nullptr, 10) * 1000000ull;
+        else if (arg == "--lateness-ms") opt.gateway.lateness_ns = std::strtoull(value(), nullptr, 10) * 1000000ull;
+        else if (arg == "--duration") opt.duration_s = std::atof(value());
+        else if (arg == "--verbose") opt.verbose = true;
+        else if (arg == "--sim-hubs") opt.sim_hubs = std::strtoul(value(), nullptr, 10);
+        else if (arg == "--sim-threads") opt.sim_threads = std::strtoul(value(), nullptr, 10);
+        else if (arg == "--sim-rate") opt.sim_rate_hz = std::atof(value());
+        else if (arg == "--sim-batch") opt.sim_batch = std::strtoul(value(), nullptr, 10);
+        else if (arg == "--sim-loss") opt.sim_loss = std::atof(value());
+        else if (arg == "--sim-tcp") opt.sim_tcp = true;
+        else if (arg == "--sim-restart") opt.sim_restart = true;
+        else if (arg == "--sim-reboot") opt.sim_reboot = true;
+        else return false;
+    }
+    if (opt.sim_hubs) {
+        if (opt.duration_s <= 0.0) opt.duration_s = 10.0;
+        if (opt.sim_threads == 0 || opt.sim_rate_hz <= 0.0 || opt.sim_batch == 0 ||
+            opt.sim_batch > SensorBatch::kCapacity) {
+            return false;
+        }
+        if ((opt.sim_tcp ? opt.gateway.tcp_port : opt.gateway.udp_port) == 0) return false;
+        if (opt.sim_restart && !opt.sim_tcp) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Simulated hubs
+
+struct SimHub {
+    uint32_t id = 0;
+    GatewayUplink uplink;
+    int64_t clock_offset_ns = 0;  // hub clock = gateway clock + offset
+    uint64_t next_send_ns = 0;
+    uint64_t sent = 0;            // samples, including dropped frames
+    uint64_t dropped = 0;         // samples in frames dropped on purpose
+    uint64_t dropped_frames = 0;
+    uint64_t reboots = 0;
+    bool connected = false;
+};
+
+class Simulator {
+public:
+    explicit Simulator(const Options& opt) : opt_(opt), hubs_(opt.sim_hubs) {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int64_t> offset(0, 3600 * 1000000000ll);
+        for (unsigned i = 0; i < hubs_.size(); ++i) {
+            hubs_[i].id = i + 1;
+            hubs_[i].clock_offset_ns = offset(rng);
+        }
+    }
+
+    bool connect() {
+        for (SimHub& hub : hubs_) {
+            if (!connect(hub)) return false;
+        }
+        return true;
+    }
+
+    void start() {
+        reboot_at_ = opt_.sim_reboot ? monotonic_ns() + static_cast<uint64_t>(opt_.duration_s * 0.5e9)
+                                     : UINT64_MAX;
+        for (unsigned t = 0; t < opt_.sim_threads; ++t) {
+            threads_.emplace_back(&Simulator::run, this, t);
+        }
+    }
+
+    void stop() {
+        stopping_ = true;
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+    const std::vector<SimHub>& hubs() const { return hubs_; }
+
+private:
+    bool connect(SimHub& hub) {
+        uint16_t port = opt_.sim_tcp ? opt_.gateway.tcp_port : opt_.gateway.udp_port;
+        hub.connected = hub.uplink.connect("127.0.0.1", port, hub.id, opt_.sim_tcp) &&
+                        hub.uplink.wait_connected(2000);
+        return hub.connected;
+    }
+
+    // As after a power cycle: the monotonic clock restarts a few seconds
+    // from zero, and a fresh uplink numbers samples from 0 under a new epoch
+    void reboot(SimHub& hub, uint64_t now) {
+        hub.clock_offset_ns = 5000000000ll - static_cast<int64_t>(now);
+        hub.uplink.close();
+        connect(hub);
+        ++hub.reboots;
+    }
+
+    void run(unsigned thread) {
+        trace::set_thread_name("sim_hubs");
+        std::mt19937_64 rng(1000 + thread);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        SensorBatch batch;
+        const uint64_t period = static_cast<uint64_t>(1e9 / opt_.sim_rate_hz);
+        const uint64_t interval = period * opt_.sim_batch;
+
+        // Stagger first sends so hubs do not transmit in lockstep
+        uint64_t now = monotonic_ns();
+        for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) {
+            hubs_[i].next_send_ns = now + static_cast<uint64_t>(unit(rng) * interval);
+        }
+
+        bool rebooted = false;
+        while (!stopping_) {
+            now = monotonic_ns();
+            if (!rebooted && now >= reboot_at_) {
+                for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) reboot(hubs_[i], now);
+                rebooted = true;
+            }
+            uint64_t next = now + interval;
+            for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) {
+                SimHub& hub = hubs_[i];
+                if (hub.next_send_ns <= now) {
+                    // The gateway starts each hub's sequence at the first
+                    // frame it sees, so that one is never dropped
+                    bool drop = hub.sent > 0 && unit(rng) < opt_.sim_loss;
+                    send(hub, batch, now, period, drop);
+                    hub.next_send_ns += interval;
+                }
+                next = std::min(next, hub.next_send_ns);
+            }
+            now = monotonic_ns();
+            if (next > now) std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+        }
+
+        // Final frame is never dropped, so an injected trailing loss still
+        // shows up as a gap; TCP outbound buffers drain around it. A link
+        // still coming back from a restart only completes its connect on a
+        // later send, so wait for it rather than lose the final frame.
+        drain(thread);
+        for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) {
+            hubs_[i].uplink.wait_connected(2000);
+        }
+        now = monotonic_ns();
+        for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) {
+            send(hubs_[i], batch, now, period, false);
+        }
+        drain(thread);
+    }
+
+    void drain(unsigned thread) {
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            bool idle = true;
+            for (size_t i = thread; i < hubs_.size(); i += opt_.sim_threads) {
+                idle = hubs_[i].uplink.flush() && idle;
+            }
+            if (idle) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    void send(SimHub& hub, SensorBatch& batch, uint64_t now, uint64_t period, bool drop) {
+        uint64_t hub_now = now + hub.clock_offset_ns;
+        batch.count = opt_.sim_batch;
+        batch.first_seq = hub.sent;
+        for (uint32_t i = 0; i < batch.count; ++i) {
+            uint64_t ts = hub_now - (batch.count - 1 - i) * period;
+            double phase = static_cast<double>(ts % 600000000000ull) / 600e9 * 6.283185307;
+            batch.timestamp[i] = ts;
+            batch.temperature[i] = 21.0f + static_cast<float>(hub.id % 7) +
+                                   2.0f * static_cast<float>(std::sin(phase));
+            batch.humidity[i] = 45.0f + 5.0f * static_cast<float>(std::cos(phase));
+            batch.flags[i] = ((hub.sent + i) % 50 == 0) ? SENSOR_FLAG_MOTION : 0;
+        }
+        hub.sent += batch.count;
+        if (drop) {
+            hub.uplink.skip(batch.count);
+            hub.dropped += batch.count;
+            ++hub.dropped_frames;
+            return;
+        }
+        hub.uplink.send(batch, hub_now);
+    }
+
+    const Options& opt_;
+    std::vector<SimHub> hubs_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stopping_{false};
+    uint64_t reboot_at_ = UINT64_MAX;
+};
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    DataLogger data_logger("gateway.db");
+    NetworkManager network_manager;
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf();
+
+    uint64_t aggregated_samples = 0;
+    Gateway gateway(opt.gateway);
+    bool started = gateway.start([&](uint64_t window_start_ns, const gateway::HubAggregate* aggs,
+                                     size_t count) {
+        TRACE_SCOPE("gateway.window", window_start_ns);
+        for (size_t i = 0; i < count; ++i) aggregated_samples += aggs[i].count;
+        data_logger.log_aggregates(window_start_ns, aggs, count);
+        network_manager.broadcast_aggregates(window_start_ns, aggs, count);
+    });
+    if (!started) return 1;
+
+    std::unique_ptr<Simulator> simulator;
+    if (opt.sim_hubs) {
+        simulator = std::make_unique<Simulator>(opt);
+        if (!simulator->connect()) {
+            std::cerr << "Simulated hubs could not connect." << std::endl;
+            return 1;
+        }
+        simulator->start();
+        std::cout << "Simulating " << opt.sim_hubs << " hubs at " << opt.sim_rate_hz
+                  << " Hz (" << opt.sim_batch << " samples/frame, "
+                  << (opt.sim_tcp ? "tcp" : "udp") << ")" << std::endl;
+    }
+    if (!opt.verbose) std::cout.rdbuf(&null_buffer);
+
+    const uint64_t start = monotonic_ns();
+    const uint64_t until = opt.duration_s > 0.0
+                               ? start + static_cast<uint64_t>(opt.duration_s * 1e9)
+                               : UINT64_MAX;
+    uint64_t restart_at = opt.sim_restart ? start + (until - start) / 2 : UINT64_MAX;
+    while (g_running && monotonic_ns() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (monotonic_ns() >= restart_at) {
+            gateway.restart_tcp();
+            std::cerr << "Restarted the TCP listener" << std::endl;
+            restart_at = UINT64_MAX;
+        }
+        gateway.poll(monotonic_ns());
+    }
+
+    if (simulator) {
+        simulator->stop();
+        // Let the final frames drain through the shards
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+    const double elapsed = (monotonic_ns() - start) / 1e9;
+    gateway.stop();
+    gateway.flush();
+    std::cout.rdbuf(saved_cout);
+
+    GatewayStats s = gateway.stats();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "PiRTOS gateway" << std::endl;
+    std::cout << "  hubs       " << s.hubs << std::endl;
+    std::cout << "  frames     " << s.frames << " (" << s.frames / elapsed << "/s)" << std::endl;
+    std::cout << "  samples    " << s.samples << " (" << s.samples / elapsed << "/s)" << std::endl;
+    std::cout << "  per shard ";
+    for (uint64_t f : s.frames_per_shard) std::cout << " " << f;
+    std::cout << std::endl;
+    std::cout << "  gaps       " << s.gap_samples << " samples" << std::endl;
+    std::cout << "  reordered  " << s.out_of_order << " frames" << std::endl;
+    std::cout << "  resyncs    " << s.resyncs << " (new hub epochs)" << std::endl;
+    std::cout << "  late       " << s.late_samples << " samples, " << s.late_aggregates
+              << " aggregates" << std::endl;
+    std::cout << "  windows    " << s.windows_released << " (" << s.aggregates << " aggregates)"
+              << std::endl;
+    std::cout << "  malformed  " << s.malformed << ", dropped " << s.frames_dropped << " frames"
+              << std::endl;
+
+    if (!simulator) return 0;
+
+    // Every sample a hub sent is either received or counted in a gap. After
+    // a restart only each epoch is accounted for (what the dropped
+    // connections held is gone unseen), and every hub must have come back.
+    std::vector<HubStats> received = gateway.hub_stats();
+    uint64_t sent = 0, injected = 0, injected_frames = 0, uplink_dropped = 0, reconnects = 0;
+    uint64_t mismatched = 0;
+    size_t r = 0;
+    for (const SimHub& hub : simulator->hubs()) {
+        sent += hub.sent;
+        uplink_dropped += hub.uplink.frames_dropped();
+        reconnects += hub.uplink.reconnects();
+        injected += hub.dropped;
+        injected_frames += hub.dropped_frames;
+        while (r < received.size() && received[r].hub_id < hub.id) ++r;
+        uint64_t accounted = 0, resyncs = 0, late = 0;
+        if (r < received.size() && received[r].hub_id == hub.id) {
+            accounted = received[r].samples + received[r].gap_samples;
+            resyncs = received[r].resyncs;
+            late = received[r].late_samples;
+        }
+        bool bad = opt.sim_restart ? accounted > hub.sent || resyncs == 0 : accounted != hub.sent;
+        // A rebooted hub's samples must land in live windows, not count as late
+        if (opt.sim_reboot) bad = bad || resyncs < hub.reboots || late != 0;
+        if (bad && mismatched++ < 5) {
+            std::cout << "  hub " << hub.id << ": sent " << hub.sent << ", accounted "
+                      << accounted << ", resyncs " << resyncs << ", late " << late << std::endl;
+        }
+    }
+    uint64_t link_lost = s.gap_samples > injected ? s.gap_samples - injected : 0;
+    std::cout << "simulation:" << std::endl;
+    std::cout << "  sent       " << sent << " samples" << std::endl;
+    std::cout << "  injected   " << injected << " samples lost in " << injected_frames
+              << " frames" << std::endl;
+    std::cout << "  link loss  " << link_lost << " samples (" << uplink_dropped
+              << " frames dropped by hub uplinks)" << std::endl;
+    std::cout << "  reconnects " << reconnects << std::endl;
+    std::cout << "  aggregated " << aggregated_samples << " samples" << std::endl;
+
+    bool ok = mismatched == 0 && (opt.sim_restart || s.gap_samples >= injected) &&
+              aggregated_samples + s.late_samples == s.samples;
+    std::cout << (ok ? "PASS" : "FAIL") << ": " << mismatched << " hubs with unaccounted samples"
+              << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "hub_pipeline.h"
+#include "config.h"
+#include "sensor_manager.h"
+#include "trace.h"
+
+HubPipelineConfig default_pipeline_config() {
+    HubPipelineConfig config;
+    config.time_align = TIME_ALIGN;
+    config.align.period_ns = TIME_ALIGN_PERIOD_MS * 1000000ull;
+    config.align.lateness_ns = TIME_ALIGN_LATENESS_MS * 1000000ull;
+    config.align.max_gap_ns = TIME_ALIGN_MAX_GAP_MS * 1000000ull;
+    config.report_by_exception = REPORT_BY_EXCEPTION;
+    config.report.mode = REPORT_SWINGING_DOOR ? ReportFilterConfig::Mode::SwingingDoor
+                                              : ReportFilterConfig::Mode::Deadband;
+    config.report.temperature = {REPORT_TEMP_DEADBAND_C, REPORT_TEMP_DEADBAND_REL};
+    config.report.humidity = {REPORT_HUMIDITY_DEADBAND, REPORT_HUMIDITY_DEADBAND_REL};
+    config.report.max_silence_ns = REPORT_MAX_SILENCE_MS * 1000000ull;
+    return config;
+}
+
+HubPipeline::HubPipeline(const HubPipelineConfig& config, SensorManager& sensors,
+                         DataLogger& logger, NetworkManager& network)
+    : config_(config), sensors_(sensors), logger_(logger), network_(network),
+      aligner_(config.align), filter_(config.report), report_pool_(1), align_pool_(1) {}
+
+void HubPipeline::publish(const SensorBatch& batch) {
+    logger_.log_batch(batch);
+    if (on_delivered_) on_delivered_(HubSink::Logger, batch);
+    network_.broadcast_batch(batch);
+    if (on_delivered_) on_delivered_(HubSink::Network, batch);
+    samples_published_ += batch.count;
+}
+
+void HubPipeline::report(const SensorBatch& batch) {
+    if (!config_.report_by_exception) {
+        publish(batch);
+        return;
+    }
+    uint32_t next = 0;
+    while (next < batch.count) {
+        BatchHandle reported = report_pool_.acquire();
+        if (!reported) {
+            samples_dropped_ += batch.count - next;
+            return;
+        }
+        reported->first_seq = batch.first_seq;
+        next = filter_.filter(batch, next, *reported);
+        if (!reported->empty()) publish(*reported);
+    }
+}
+
+// Fused records the watermark has released; `flush` at end of input
+void HubPipeline::report_aligned(uint64_t first_seq, bool flush) {
+    while (true) {
+        BatchHandle aligned = align_pool_.acquire();
+        if (!aligned) return;  // records stay buffered in the aligner for the next drain
+        aligned->first_seq = first_seq;
+        if (flush) aligner_.flush(*aligned);
+        else aligner_.drain(*aligned);
+        if (aligned->empty()) break;
+        report(*aligned);
+    }
+}
+
+void HubPipeline::handle(const SensorBatch& batch) {
+    TRACE_SCOPE("hub.batch", batch.first_seq);
+    if (config_.time_align) {
+        aligner_.ingest(batch);
+        report_aligned(batch.first_seq, false);
+    } else {
+        report(batch);
+    }
+    // Alerts see every sample, not just the reported ones
+    sensors_.check_alerts(batch);
+    if (on_delivered_) on_delivered_(HubSink::Alerts, batch);
+}
+
+void HubPipeline::finish(uint64_t next_seq) {
+    if (config_.time_align) report_aligned(next_seq, true);
+    if (config_.report_by_exception) {
+        BatchHandle reported = report_pool_.acquire();
+        if (!reported) {
+            ++samples_dropped_;  // the held trend point
+            return;
+        }
+        filter_.flush(*reported);
+        if (!reported->empty()) publish(*reported);
+    }
+}
@@ -0,0 +1,316 @@
+// pirtos_loadtest: drives the hub's pipeline (SensorManager -> HubPipeline, the
+// same aligner/filter/sink/alert chain pirtos_hub runs) from a synthetic or
+// replayed source and reports sustained throughput, drops and end-to-end
+// latency percentiles.
+//
+//   pirtos_loadtest --rate 100000 --duration 10
+//   pirtos_loadtest --rate 100000 --no-align --no-rbe  # every sample to the sinks
+//   pirtos_loadtest --rate 1000 --pattern burst --burst-size 200 --events 5
+//   pirtos_loadtest --replay capture.csv --realtime --loop --duration 60
+//   pirtos_loadtest --rate 50000 --check-allocs   # fail on steady-state heap use
+//   pirtos_loadtest --rate 1000 --duration 2 --trace trace.json
+//   pirtos_loadtest --rate 100000 --reactor epoll   # coroutine update loop
+//   pirtos_loadtest --rate 100000 --shm /pirtos_load # also publish to shm
+
+#include "sensor_manager.h"
+#include "data_logger.h"
+#include "network_manager.h"
+#include "hub_pipeline.h"
+#include "latency_histogram.h"
+#include "alloc_counter.h"
+#include "trace.h"
+#include "reactor.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct Options {
+    SyntheticConfig synthetic;
+    std::string replay_path;
+    bool realtime = false;
+    bool loop = false;
+    double duration_s = 10.0;
+    double warmup_s = 1.0;
+    int flush_ms = 10;
+    bool check_allocs = false;
+    bool no_align = false;      // skip the TimeAligner stage
+    bool no_rbe = false;        // skip report-by-exception
+    std::string trace_path;
+    std::string reactor;  // empty = threaded update loop
+    std::string shm_name;
+    bool verbose = false;
+};
+
+// Swallows pipeline output while still paying the formatting cost.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+void usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " [options]\n"
+        << "  --rate HZ          synthetic sample rate (default 1000)\n"
+        << "  --pattern P        steady | burst (default steady)\n"
+        << "  --burst-size N     samples per burst (default 100)\n"
+        << "  --events HZ        motion/button edges per second (default 0)\n"
+        << "  --samples N        stop after N synthetic samples\n"
+        << "  --replay FILE      replay a capture instead of synthesizing\n"
+        << "  --realtime         replay at recorded pace (default: max speed)\n"
+        << "  --loop             restart the capture when it ends\n"
+        << "  --duration S       measurement window in seconds (default 10)\n"
+        << "  --warmup S         discarded warm-up in seconds (default 1)\n"
+        << "  --flush-ms MS      publish partial batches after MS (default 10)\n"
+        << "  --no-align         feed raw batches on without time alignment\n"
+        << "  --no-rbe           send every sample to the logger and network\n"
+        << "  --check-allocs     fail if the pipeline allocates after warm-up\n"
+        << "  --trace FILE       write a Chrome Trace / Perfetto JSON timeline\n"
+        << "  --reactor B        run the update loop on a uring | epoll reactor\n"
+        << "  --shm NAME         also publish into shared-memory ring NAME\n"
+        << "  --verbose          keep logger/network/alert output\n";
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    opt.synthetic.rate_hz = 1000.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--rate") opt.synthetic.rate_hz = std::atof(value());
+        else if (arg == "--pattern") {
+            std::string p = value();
+            if (p == "burst") opt.synthetic.pattern = SyntheticConfig::Pattern::Burst;
+            else if (p == "steady") opt.synthetic.pattern = SyntheticConfig::Pattern::Steady;
+            else return false;
+        }
+        else if (arg == "--burst-size") opt.synthetic.burst_size = std::strtoul(value(), nullptr, 10);
+        else if (arg == "--events") opt.synthetic.event_rate_hz = std::atof(value());
+        else if (arg == "--samples") opt.synthetic.max_samples = std::strtoull(value(), nullptr, 10);
+        else if (arg == "--replay") opt.replay_path = value();
+        else if (arg == "--realtime") opt.realtime = true;
+        else if (arg == "--loop") opt.loop = true;
+        else if (arg == "--duration") opt.duration_s = std::atof(value());
+        else if (arg == "--warmup") opt.warmup_s = std::atof(value());
+        else if (arg == "--flush-ms") opt.flush_ms = std::atoi(value());
+        else if (arg == "--no-align") opt.no_align = true;
+        else if (arg == "--no-rbe") opt.no_rbe = true;
+        else if (arg == "--check-allocs") opt.check_allocs = true;
+        else if (arg == "--trace") opt.trace_path = value();
+        else if (arg == "--reactor") {
+            opt.reactor = value();
+            if (opt.reactor != "uring" && opt.reactor != "epoll") return false;
+        }
+        else if (arg == "--shm") opt.shm_name = value();
+        else if (arg == "--verbose") opt.verbose = true;
+        else return false;
+    }
+    return true;
+}
+
+void print_latency(const char* stage, const LatencyHistogram& h) {
+    std::cout << "  " << std::left << std::setw(8) << stage << std::right
+              << " p50=" << std::setw(9) << h.percentile(50) / 1000.0 << "us"
+              << " p90=" << std::setw(9) << h.percentile(90) / 1000.0 << "us"
+              << " p99=" << std::setw(9) << h.percentile(99) / 1000.0 << "us"
+              << " p99.9=" << std::setw(9) << h.percentile(99.9) / 1000.0 << "us"
+              << " max=" << std::setw(9) << h.max() / 1000.0 << "us" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<SensorSource> source;
+    if (!opt.replay_path.empty()) {
+        source = std::make_unique<ReplaySensorSource>(opt.replay_path, opt.realtime, opt.loop);
+    } else {
+        source = std::make_unique<SyntheticSensorSource>(opt.synthetic);
+    }
+
+    SensorManager sensor_manager(std::move(source));
+    sensor_manager.set_batch_flush_interval(std::chrono::milliseconds(opt.flush_ms));
+    if (!opt.shm_name.empty() && !sensor_manager.enable_shm_channel(opt.shm_name, 65536)) {
+        return 1;
+    }
+    DataLogger data_logger("loadtest.db");
+    NetworkManager network_manager;
+
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf();
+
+    trace::TraceWriter trace_writer;
+    if (!opt.trace_path.empty()) {
+        if (!trace_writer.open(opt.trace_path)) {
+            std::cerr << "Cannot open trace file " << opt.trace_path << std::endl;
+            return 1;
+        }
+        trace::set_thread_name("loadtest_consumer");
+        trace::set_enabled(true);
+    }
+
+    // --reactor: the coroutine update loop runs on its own reactor thread,
+    // consumed exactly like the threaded one
+    std::unique_ptr<Reactor> reactor;
+    std::thread reactor_thread;
+    bool initialized;
+    if (!opt.reactor.empty()) {
+        reactor = std::make_unique<Reactor>(opt.reactor == "uring");
+        if (opt.reactor == "uring" && reactor->backend() != Reactor::Backend::IoUring) {
+            std::cerr << "io_uring unavailable; using " << reactor->backend_name() << std::endl;
+        }
+        initialized = reactor->valid() && sensor_manager.initialize(*reactor);
+        if (initialized) {
+            reactor_thread = std::thread([&] {
+                trace::set_thread_name("reactor");
+                reactor->run();
+            });
+        }
+    } else {
+        initialized = sensor_manager.initialize();
+    }
+    if (!initialized) {
+        std::cerr << "Failed to initialize SensorManager. Exiting." << std::endl;
+        return 1;
+    }
+    if (!opt.verbose) std::cout.rdbuf(&null_buffer);
+
+    // Aligned and filtered, the sinks see a small fraction of the input;
+    // --no-align --no-rbe loads them with every sample
+    HubPipelineConfig pipeline_config = default_pipeline_config();
+    if (opt.no_align) pipeline_config.time_align = false;
+    if (opt.no_rbe) pipeline_config.report_by_exception = false;
+    HubPipeline pipeline(pipeline_config, sensor_manager, data_logger, network_manager);
+
+    LatencyHistogram to_logger, to_network, to_alerts, to_done;
+    uint64_t consumed = 0;
+    uint64_t warm_received = 0, warm_dropped = 0, warm_allocs = 0;
+
+    const uint64_t start = monotonic_ns();
+    const uint64_t measure_from = start + static_cast<uint64_t>(opt.warmup_s * 1e9);
+    const uint64_t measure_until = measure_from + static_cast<uint64_t>(opt.duration_s * 1e9);
+    bool measuring = false;
+    uint64_t measure_start = measure_from;
+
+    auto record = [](LatencyHistogram& h, const SensorBatch& b, uint64_t t) {
+        for (uint32_t i = 0; i < b.count; ++i) {
+            h.record(t > b.timestamp[i] ? t - b.timestamp[i] : 0);
+        }
+    };
+    // Logger and network get whatever the stages pass on (raw, aligned or
+    // filtered); alerts get every raw batch
+    pipeline.on_delivered([&](HubSink sink, const SensorBatch& b) {
+        if (!measuring) return;
+        LatencyHistogram& h = sink == HubSink::Logger    ? to_logger
+                              : sink == HubSink::Network ? to_network
+                                                         : to_alerts;
+        record(h, b, monotonic_ns());
+    });
+    uint64_t warm_published = 0, warm_pipeline_dropped = 0;
+
+    uint64_t next_trace_flush = start;
+    while (true) {
+        uint64_t now = monotonic_ns();
+        if (now >= measure_until) break;
+        if (trace_writer.is_open() && now >= next_trace_flush) {
+            trace_writer.flush();
+            next_trace_flush = now + 100000000ull;
+        }
+        if (!measuring && now >= measure_from) {
+            measuring = true;
+            measure_start = now;
+            warm_received = sensor_manager.samples_received();
+            warm_dropped = sensor_manager.samples_dropped();
+            warm_allocs = alloc_counter::allocations();
+            warm_published = pipeline.samples_published();
+            warm_pipeline_dropped = pipeline.samples_dropped();
+        }
+
+        BatchHandle batch;
+        if (!sensor_manager.wait_for_batch(batch, std::chrono::milliseconds(100))) {
+            if (sensor_manager.source_finished()) break;
+            continue;
+        }
+
+        pipeline.handle(*batch);
+        uint64_t t_done = monotonic_ns();
+
+        if (!measuring) continue;
+        consumed += batch->count;
+        record(to_done, *batch, t_done);
+    }
+
+    const uint64_t measure_end = monotonic_ns();
+    const uint64_t allocs = alloc_counter::allocations() - warm_allocs;
+    const uint64_t produced = sensor_manager.samples_received() - warm_received;
+    const uint64_t dropped = sensor_manager.samples_dropped() - warm_dropped;
+    const uint64_t published = pipeline.samples_published() - warm_published;
+    const uint64_t pipeline_dropped = pipeline.samples_dropped() - warm_pipeline_dropped;
+    sensor_manager.shutdown();
+    if (reactor_thread.joinable()) reactor_thread.join();
+    std::cout.rdbuf(saved_cout);
+    if (trace_writer.is_open()) {
+        trace_writer.close();
+        std::cout << "trace written to " << opt.trace_path
+                  << " (dropped " << trace::dropped() << " events)" << std::endl;
+    }
+
+    double elapsed = measuring ? (measure_end - measure_start) / 1e9 : 0.0;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "PiRTOS load test" << std::endl;
+    if (elapsed <= 0.0) {
+        std::cout << "  no samples in the measurement window" << std::endl;
+        return 1;
+    }
+    std::cout << "  window    " << elapsed << " s" << std::endl;
+    std::cout << "  produced  " << produced << " (" << produced / elapsed << "/s)" << std::endl;
+    std::cout << "  consumed  " << consumed << " (" << consumed / elapsed << "/s)" << std::endl;
+    std::cout << "  dropped   " << dropped << " ("
+              << (produced ? 100.0 * dropped / produced : 0.0) << "%)" << std::endl;
+    const bool align = pipeline.config().time_align, rbe = pipeline.config().report_by_exception;
+    const char* stages = align && rbe ? " after alignment and report-by-exception"
+                         : align      ? " after alignment"
+                         : rbe        ? " after report-by-exception"
+                                      : ", raw";
+    std::cout << "  published " << published << " (" << (consumed ? 100.0 * published / consumed : 0.0)
+              << "%" << stages << ")" << std::endl;
+    if (pipeline_dropped != 0) {
+        std::cout << "  pipeline dropped " << pipeline_dropped << " (batch pool exhausted)"
+                  << std::endl;
+    }
+    std::cout << "latency from sample timestamp:" << std::endl;
+    if (to_logger.count()) {
+        print_latency("logger", to_logger);
+        print_latency("network", to_network);
+    } else {
+        std::cout << "  logger   nothing published in the window" << std::endl;
+        std::cout << "  network  nothing published in the window" << std::endl;
+    }
+    print_latency("alerts", to_alerts);
+    print_latency("pipeline", to_done);
+    std::cout << "heap allocations after warm-up: " << allocs << std::endl;
+    if (opt.check_allocs && allocs != 0) {
+        std::cout << "FAIL: steady-state pipeline allocated" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,55 +1,123 @@
 #include "sensor_manager.h"
 #include "data_logger.h"
 #include "network_manager.h"
+#include "hub_pipeline.h"
 #include "config.h"
+#include "trace.h"
+#include "reactor.h"
 #include <atomic>
 #include <chrono>
 #include <csignal>
+#include <cstdlib>
 #include <iostream>
-#include <thread>
+#include <poll.h>
+#include <unistd.h>
 
 std::atomic<bool> running{true};
 
 void signal_handler(int) { running = false; }
 
+// SIGUSR2 toggles tracing at runtime (only meaningful with PIRTOS_TRACE set)
+void trace_toggle_handler(int) { trace::set_enabled(!trace::enabled()); }
+
+// Waits for published batches and hands them to `handle`; also owns the
+// periodic trace flush. Stops the sensor loop on the way out.
+template <typename Handler>
+AsyncTask<> hub_loop(Reactor& reactor, SensorManager& sensor_manager,
+                     trace::TraceWriter& trace_writer, Handler& handle) {
+    auto next_trace_flush = std::chrono::steady_clock::now();
+    while (running) {
+        if (trace_writer.is_open() && std::chrono::steady_clock::now() >= next_trace_flush) {
+            trace_writer.flush();
+            next_trace_flush += std::chrono::seconds(1);
+        }
+
+        int64_t ready = co_await reactor.poll(sensor_manager.batch_event_fd(), POLLIN,
+                                              std::chrono::milliseconds(50));
+        if (ready <= 0) continue;
+        uint64_t events;
+        ssize_t n = ::read(sensor_manager.batch_event_fd(), &events, sizeof(events));
+        (void)n;
+
+        BatchHandle batch;
+        while (sensor_manager.wait_for_batch(batch, std::chrono::milliseconds(0))) {
+            handle(batch);
+            batch.reset();
+        }
+    }
+    sensor_manager.shutdown();
+}
+
 int main() {
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
+    // PIRTOS_TRACE=<file> streams Chrome Trace / Perfetto JSON to <file>
+    trace::TraceWriter trace_writer;
+    if (const char* trace_path = std::getenv("PIRTOS_TRACE")) {
+        if (trace_writer.open(trace_path)) {
+            trace::set_thread_name("hub_main");
+            trace::set_enabled(true);
+            std::signal(SIGUSR2, trace_toggle_handler);
+        } else {
+            std::cerr << "Cannot open trace file " << trace_path << std::endl;
+        }
+    }
+
+    // Sensor updates and batch handling share this thread
+    Reactor reactor;
+    if (!reactor.valid()) {
+        std::cerr << "Failed to create I/O reactor. Exiting." << std::endl;
+        return 1;
+    }
+
     SensorManager sensor_manager;
-    if (!sensor_manager.initialize()) {
+    if (SHM_CHANNEL && !sensor_manager.enable_shm_channel(SHM_CHANNEL_NAME, SHM_CHANNEL_CAPACITY)) {
+        std::cerr << "Shared-memory channel unavailable; continuing without it." << std::endl;
+    }
+    if (!sensor_manager.initialize(reactor)) {
         std::cerr << "Failed to initialize SensorManager. Exiting." << std::endl;
         return 1;
     }
 
     DataLogger data_logger("sensor_data.db");
     NetworkManager network_manager;
+    if (GATEWAY_UPLINK &&
+        !network_manager.connect_gateway(GATEWAY_HOST, GATEWAY_PORT, HUB_ID, GATEWAY_UPLINK_TCP)) {
+        std::cerr << "Gateway uplink unavailable; continuing without it." << std::endl;
+    }
 
-    std::cout << "PiRTOS Sensor Hub Started. Press Ctrl+C to exit." << std::endl;
-
-    using clock = std::chrono::steady_clock;
-    auto next_log = clock::now();
-    auto next_alert = clock::now();
-
-    while (running) {
-        auto now = clock::now();
+    HubPipeline pipeline(default_pipeline_config(), sensor_manager, data_logger, network_manager);
 
-        if (now >= next_log) {
-            auto data = sensor_manager.read_sensors();
-            data_logger.log_data(data);
-            network_manager.broadcast_data(data);
-            next_log = now + std::chrono::milliseconds(DATA_LOG_INTERVAL_MS);
-        }
+    // Samples arrive in pooled batches; each batch is handed to every stage by
+    // handle and recycled once the last stage drops it.
+    auto handle_batch = [&](const BatchHandle& batch) { pipeline.handle(*batch); };
 
-        if (now >= next_alert) {
-            sensor_manager.check_alerts();
-            next_alert = now + std::chrono::milliseconds(5000);
-        }
+    std::cout << "PiRTOS Sensor Hub Started. Press Ctrl+C to exit." << std::endl;
+    reactor.spawn(hub_loop(reactor, sensor_manager, trace_writer, handle_batch));
+    reactor.run();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // The update loop published its partial batch on the way out
+    BatchHandle leftover;
+    while (sensor_manager.wait_for_batch(leftover, std::chrono::milliseconds(0))) {
+        handle_batch(leftover);
+        leftover.reset();
+    }
+    pipeline.finish(sensor_manager.samples_received());
+    if (TIME_ALIGN) {
+        std::cout << "Time alignment: " << pipeline.aligner().records_out() << " records, "
+                  << pipeline.aligner().late() << " late readings" << std::endl;
+    }
+    if (REPORT_BY_EXCEPTION) {
+        std::cout << "Report-by-exception: " << pipeline.filter().samples_out() << " of "
+                  << pipeline.filter().samples_in() << " samples reported" << std::endl;
+    }
+    if (pipeline.samples_dropped() != 0) {
+        std::cerr << "Pipeline dropped " << pipeline.samples_dropped()
+                  << " samples on an exhausted batch pool" << std::endl;
     }
 
-    sensor_manager.shutdown();
+    trace_writer.close();
     std::cout << "PiRTOS Sensor Hub Stopped." << std::endl;
     return 0;
 }
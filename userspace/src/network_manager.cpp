@@ -1,4 +1,6 @@
 #include "network_manager.h"
+#include "common.h"
+#include "trace.h"
 #include <iostream>
 
 void NetworkManager::broadcast_data(const SensorData& data) {
@@ -11,3 +13,45 @@ void NetworkManager::broadcast_data(const SensorData& data) {
               << "ts=" << data.timestamp
               << std::endl;
 }
+
+void NetworkManager::broadcast_batch(const SensorBatch& batch) {
+    TRACE_SCOPE("network.broadcast_batch", batch.first_seq);
+    trace::flow("sample", trace::Phase::FlowStep, batch.first_seq);
+    // Stub: one publish per batch once a real transport exists.
+    for (uint32_t i = 0; i < batch.count; ++i) {
+        std::cout << "[NET] broadcast "
+                  << "temp=" << batch.temperature[i] << "C "
+                  << "hum=" << batch.humidity[i] << "% "
+                  << "motion=" << ((batch.flags[i] & SENSOR_FLAG_MOTION) ? 1 : 0) << " "
+                  << "button=" << ((batch.flags[i] & SENSOR_FLAG_BUTTON) ? 1 : 0) << " "
+                  << "ts=" << batch.timestamp[i]
+                  << '\n';
+    }
+    std::cout.flush();
+
+    // No-op without a gateway; a dropped TCP link reconnects from here
+    uplink_.send(batch, monotonic_ns());
+}
+
+void NetworkManager::broadcast_aggregates(uint64_t window_start_ns,
+                                          const gateway::HubAggregate* aggs, size_t count) {
+    // Stub: one upstream publish per window once a real transport exists.
+    for (size_t i = 0; i < count; ++i) {
+        const gateway::HubAggregate& a = aggs[i];
+        std::cout << "[NET] aggregate window=" << window_start_ns << " "
+                  << "hub=" << a.hub_id << " "
+                  << "n=" << a.count << " "
+                  << "temp=" << a.temp_min << "/" << a.temp_mean << "/" << a.temp_max << "C "
+                  << "hum=" << a.hum_min << "/" << a.hum_mean << "/" << a.hum_max << "% "
+                  << "motion=" << a.motion_events << " "
+                  << "button=" << a.button_events << " "
+                  << "gaps=" << a.gap_samples
+                  << '\n';
+    }
+    std::cout.flush();
+}
+
+bool NetworkManager::connect_gateway(const std::string& host, uint16_t port, uint32_t hub_id,
+                                     bool tcp) {
+    return uplink_.connect(host, port, hub_id, tcp);
+}
@@ -0,0 +1,240 @@
+// C reader for the shared-memory sample channel (pirtos_shm.h). Kept free of
+// C++ so dashboards, scripts (via FFI) and the watchdog can link it alone.
+
+#define _GNU_SOURCE
+#include "pirtos_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(struct pirtos_shm_header) == 128, "shm header layout changed");
+_Static_assert(sizeof(struct pirtos_shm_record) == PIRTOS_SHM_RECORD_V1_BYTES,
+               "shm record layout changed");
+
+struct descriptor {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint64_t epoch;
+};
+
+// Consistent copy of the header descriptor; fails only if a publisher keeps
+// it locked (crashed mid-initialization).
+static int read_descriptor(const struct pirtos_shm_header* h, struct descriptor* d) {
+    for (int attempt = 0; attempt < 10000; ++attempt) {
+        uint32_t s1 = __atomic_load_n(&h->desc_seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1u) {
+            sched_yield();
+            continue;
+        }
+        d->magic = __atomic_load_n(&h->magic, __ATOMIC_RELAXED);
+        d->version = __atomic_load_n(&h->version, __ATOMIC_RELAXED);
+        d->record_size = __atomic_load_n(&h->record_size, __ATOMIC_RELAXED);
+        d->capacity = __atomic_load_n(&h->capacity, __ATOMIC_RELAXED);
+        d->epoch = __atomic_load_n(&h->epoch, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->desc_seq, __ATOMIC_RELAXED) == s1) return 0;
+    }
+    return -EAGAIN;
+}
+
+// Sleep between checks for readers that cannot register as futex waiters
+#define READ_ONLY_POLL_NS 1000000L
+
+static int valid_descriptor(const struct descriptor* d) {
+    return d->magic == PIRTOS_SHM_MAGIC && d->version == PIRTOS_SHM_VERSION &&
+           d->record_size >= PIRTOS_SHM_RECORD_V1_BYTES && d->record_size % 8 == 0 &&
+           d->capacity >= 8 && (d->capacity & (d->capacity - 1)) == 0;
+}
+
+int pirtos_shm_open(pirtos_shm_reader* r, const char* name) {
+    memset(r, 0, sizeof(*r));
+    // Write access is only needed to register futex waits; without it
+    // (another user's ring) reads work the same and waits poll instead
+    int read_only = 0;
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0 && errno == EACCES) {
+        fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        read_only = 1;
+    }
+    if (fd < 0) return -errno;
+
+    int rc = -EPROTO;
+    struct stat st;
+    struct descriptor d;
+    void* header = MAP_FAILED;
+    void* slots = MAP_FAILED;
+    size_t slots_bytes = 0;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)PIRTOS_SHM_HEADER_BYTES) goto out;
+    header = mmap(NULL, PIRTOS_SHM_HEADER_BYTES, read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+                  MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED) {
+        rc = -errno;
+        goto out;
+    }
+    rc = read_descriptor(header, &d);
+    if (rc < 0) goto out;
+    rc = -EPROTO;
+    if (!valid_descriptor(&d)) goto out;
+    slots_bytes = (size_t)d.capacity * d.record_size;
+    if ((uint64_t)st.st_size < PIRTOS_SHM_HEADER_BYTES + (uint64_t)slots_bytes) goto out;
+    slots = mmap(NULL, slots_bytes, PROT_READ, MAP_SHARED, fd, PIRTOS_SHM_HEADER_BYTES);
+    if (slots == MAP_FAILED) {
+        rc = -errno;
+        goto out;
+    }
+
+    r->header = header;
+    r->slots = slots;
+    r->slots_bytes = slots_bytes;
+    r->epoch = d.epoch;
+    r->record_size = d.record_size;
+    r->capacity = d.capacity;
+    r->read_only = read_only;
+    r->next = __atomic_load_n(&r->header->write_seq, __ATOMIC_ACQUIRE);
+    rc = 0;
+
+out:
+    if (rc < 0 && header != MAP_FAILED) munmap(header, PIRTOS_SHM_HEADER_BYTES);
+    close(fd);
+    return rc;
+}
+
+void pirtos_shm_close(pirtos_shm_reader* r) {
+    if (r->slots) munmap((void*)r->slots, r->slots_bytes);
+    if (r->header) munmap(r->header, PIRTOS_SHM_HEADER_BYTES);
+    memset(r, 0, sizeof(*r));
+}
+
+void pirtos_shm_seek_oldest(pirtos_shm_reader* r) {
+    uint64_t w = __atomic_load_n(&r->header->write_seq, __ATOMIC_ACQUIRE);
+    r->next = w > r->capacity ? w - r->capacity : 0;
+}
+
+// Lapped: land a quarter ring ahead of the oldest record so the following
+// reads have room before the writer catches up again.
+static void skip_ahead(pirtos_shm_reader* r, uint64_t write_seq) {
+    uint64_t keep = r->capacity - r->capacity / 4;
+    uint64_t target = write_seq > keep ? write_seq - keep : 0;
+    if (target <= r->next) target = r->next + 1;
+    r->overruns += target - r->next;
+    r->next = target;
+}
+
+// A publisher took the ring over: same layout continues from its start,
+// anything else needs a fresh mapping.
+static int follow_epoch(pirtos_shm_reader* r) {
+    struct descriptor d;
+    int rc = read_descriptor(r->header, &d);
+    if (rc < 0) return rc;
+    if (d.epoch == PIRTOS_SHM_EPOCH_RETIRED || !valid_descriptor(&d) ||
+        d.record_size != r->record_size || d.capacity != r->capacity) {
+        return -ESTALE;
+    }
+    r->epoch = d.epoch;
+    r->next = 0;
+    return 0;
+}
+
+int pirtos_shm_read(pirtos_shm_reader* r, struct pirtos_shm_record* out, size_t max) {
+    struct pirtos_shm_header* h = r->header;
+    if (__atomic_load_n(&h->epoch, __ATOMIC_ACQUIRE) != r->epoch) {
+        int rc = follow_epoch(r);
+        if (rc < 0) return rc;
+    }
+
+    const size_t copy = r->record_size < sizeof(*out) ? r->record_size : sizeof(*out);
+    const uint64_t mask = r->capacity - 1;
+    uint64_t w = __atomic_load_n(&h->write_seq, __ATOMIC_ACQUIRE);
+    size_t n = 0;
+    if (max > INT_MAX) max = INT_MAX;
+    while (n < max && r->next < w) {
+        if (w - r->next > r->capacity) {
+            skip_ahead(r, w);
+            continue;
+        }
+        const uint8_t* slot = r->slots + (r->next & mask) * r->record_size;
+        const uint64_t* seq = (const uint64_t*)slot;
+        const uint64_t want = 2 * r->next + 2;
+        if (__atomic_load_n(seq, __ATOMIC_ACQUIRE) == want) {
+            memcpy(&out[n], slot, copy);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(seq, __ATOMIC_RELAXED) == want) {
+                out[n].seq = r->next;
+                ++n;
+                ++r->next;
+                continue;
+            }
+        }
+        // The writer reused the slot while we were copying it
+        w = __atomic_load_n(&h->write_seq, __ATOMIC_ACQUIRE);
+        skip_ahead(r, w);
+    }
+    return (int)n;
+}
+
+static int has_news(const pirtos_shm_reader* r) {
+    const struct pirtos_shm_header* h = r->header;
+    return __atomic_load_n(&h->write_seq, __ATOMIC_SEQ_CST) != r->next ||
+           __atomic_load_n(&h->epoch, __ATOMIC_RELAXED) != r->epoch;
+}
+
+int pirtos_shm_wait(pirtos_shm_reader* r, int timeout_ms) {
+    struct pirtos_shm_header* h = r->header;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            ++deadline.tv_sec;
+        }
+    }
+
+    for (;;) {
+        uint32_t word = __atomic_load_n(&h->futex, __ATOMIC_ACQUIRE);
+        if (has_news(r)) return 1;
+        if (timeout_ms == 0) return 0;
+
+        struct timespec left = {0, 0};
+        if (timeout_ms > 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec = deadline.tv_sec - now.tv_sec;
+            left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) {
+                left.tv_nsec += 1000000000L;
+                --left.tv_sec;
+            }
+            if (left.tv_sec < 0) return 0;
+        }
+
+        if (r->read_only) {
+            // Not registered as a waiter, so no publisher wakes us
+            struct timespec tick = {0, READ_ONLY_POLL_NS};
+            if (timeout_ms > 0 && left.tv_sec == 0 && left.tv_nsec < tick.tv_nsec) tick = left;
+            nanosleep(&tick, NULL);
+            continue;
+        }
+
+        // The publisher bumps the futex word and then checks waiters; the
+        // re-check after registering closes the window in between.
+        __atomic_add_fetch(&h->waiters, 1, __ATOMIC_SEQ_CST);
+        if (!has_news(r)) {
+            syscall(SYS_futex, &h->futex, FUTEX_WAIT, word, timeout_ms > 0 ? &left : NULL,
+                    NULL, 0);
+        }
+        __atomic_sub_fetch(&h->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
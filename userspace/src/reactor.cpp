@@ -0,0 +1,650 @@
+#include "reactor.h"
+#include "common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+class Reactor::Impl {
+public:
+    virtual ~Impl() = default;
+    virtual bool valid() const = 0;
+    virtual Backend backend() const = 0;
+    virtual bool try_complete(IoOp& op) = 0;
+    virtual void submit(IoOp& op) = 0;
+    // Asks for an in-flight op to finish early; it still completes through
+    // wait(), with any result.
+    virtual void cancel(IoOp& op) = 0;
+    // Blocks for at least one completion (or the wake eventfd) and appends the
+    // finished operations to `done`. Returns false when asked to stop.
+    virtual bool wait(std::vector<IoOp*>& done) = 0;
+
+    int wake_fd = -1;
+};
+
+namespace {
+
+constexpr uint64_t kWakeToken = 1;   // user_data of the wake eventfd read
+constexpr uint64_t kIgnoreToken = 0; // user_data of linked poll timeouts
+
+__kernel_timespec to_timespec(uint64_t ns) {
+    __kernel_timespec ts{};
+    ts.tv_sec = static_cast<int64_t>(ns / 1000000000ull);
+    ts.tv_nsec = static_cast<long long>(ns % 1000000000ull);
+    return ts;
+}
+
+int64_t run_syscall(IoOp& op) {
+    ssize_t n = -1;
+    switch (op.kind) {
+    case IoOp::Kind::Read:
+        n = op.offset < 0 ? ::read(op.fd, op.buf, op.len) : ::pread(op.fd, op.buf, op.len, op.offset);
+        break;
+    case IoOp::Kind::Write:
+        n = op.offset < 0 ? ::write(op.fd, op.buf, op.len) : ::pwrite(op.fd, op.buf, op.len, op.offset);
+        break;
+    case IoOp::Kind::Send:
+        n = ::send(op.fd, op.buf, op.len, op.flags | MSG_DONTWAIT);
+        break;
+    default:
+        break;
+    }
+    return n >= 0 ? n : -errno;
+}
+
+// ---------------------------------------------------------------------------
+// io_uring backend, driven through the raw syscalls (no liburing dependency)
+
+class UringImpl : public Reactor::Impl {
+public:
+    explicit UringImpl(unsigned entries) {
+        io_uring_params p{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (ring_fd_ < 0) return;
+
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+        sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring_fd_, IORING_OFF_SQ_RING);
+        cq_ptr_ = single ? sq_ptr_
+                         : ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                                  IORING_OFF_SQES));
+        if (sq_ptr_ == MAP_FAILED || cq_ptr_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+            teardown();
+            return;
+        }
+
+        auto* sq = static_cast<char*>(sq_ptr_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        auto* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        sq_entries_ = p.sq_entries;
+
+        wake_fd = ::eventfd(0, EFD_CLOEXEC);
+        if (wake_fd < 0) {
+            teardown();
+            return;
+        }
+        arm_wake();
+    }
+
+    ~UringImpl() override {
+        teardown();
+        if (wake_fd >= 0) ::close(wake_fd);
+    }
+
+    bool valid() const override { return ring_fd_ >= 0; }
+    Reactor::Backend backend() const override { return Reactor::Backend::IoUring; }
+
+    bool try_complete(IoOp& op) override {
+        if (op.kind == IoOp::Kind::Timeout && monotonic_ns() >= op.deadline_ns) {
+            op.result = 0;
+            return true;
+        }
+        return false;
+    }
+
+    void submit(IoOp& op) override {
+        // A poll and its LINK_TIMEOUT must go to the kernel in one batch
+        if (op.kind == IoOp::Kind::Poll && op.deadline_ns) reserve(2);
+        io_uring_sqe* sqe = next_sqe();
+        auto token = reinterpret_cast<uint64_t>(&op);
+        switch (op.kind) {
+        case IoOp::Kind::Read:
+            prep(sqe, IORING_OP_READ, op.fd, op.buf, op.len, op.offset, token);
+            break;
+        case IoOp::Kind::Write:
+            prep(sqe, IORING_OP_WRITE, op.fd, op.buf, op.len, op.offset, token);
+            break;
+        case IoOp::Kind::Send:
+            prep(sqe, IORING_OP_SEND, op.fd, op.buf, op.len, 0, token);
+            sqe->msg_flags = static_cast<unsigned>(op.flags);
+            break;
+        case IoOp::Kind::Poll:
+            prep(sqe, IORING_OP_POLL_ADD, op.fd, nullptr, 0, 0, token);
+            sqe->poll32_events = static_cast<unsigned>(op.flags);
+            if (op.deadline_ns) {
+                sqe->flags |= IOSQE_IO_LINK;
+                deadline_ = to_timespec(op.deadline_ns);
+                io_uring_sqe* tmo = next_sqe();
+                prep(tmo, IORING_OP_LINK_TIMEOUT, -1, &deadline_, 1, 0, kIgnoreToken);
+                tmo->timeout_flags = IORING_TIMEOUT_ABS;
+            }
+            break;
+        case IoOp::Kind::Timeout:
+            deadline_ = to_timespec(op.deadline_ns);
+            prep(sqe, IORING_OP_TIMEOUT, -1, &deadline_, 1, 0, token);
+            sqe->timeout_flags = IORING_TIMEOUT_ABS;
+            break;
+        }
+        // Timespecs are copied at submission, so submit before reusing deadline_
+        if (op.kind == IoOp::Kind::Timeout || op.kind == IoOp::Kind::Poll) flush_sq(0);
+    }
+
+    void cancel(IoOp& op) override {
+        uint8_t opcode = op.kind == IoOp::Kind::Timeout ? IORING_OP_TIMEOUT_REMOVE
+                                                         : IORING_OP_ASYNC_CANCEL;
+        prep(next_sqe(), opcode, -1, &op, 0, 0, kIgnoreToken);
+    }
+
+    bool wait(std::vector<IoOp*>& done) override {
+        if (flush_sq(1) < 0 && errno != EINTR) {
+            std::cerr << "Reactor: io_uring_enter failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        bool keep_going = true;
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data == kIgnoreToken) continue;
+            if (cqe.user_data == kWakeToken) {
+                keep_going = false;
+                arm_wake();
+                continue;
+            }
+            auto* op = reinterpret_cast<IoOp*>(cqe.user_data);
+            op->result = cqe.res;
+            if (op->kind == IoOp::Kind::Timeout && cqe.res == -ETIME) op->result = 0;
+            if (op->kind == IoOp::Kind::Poll && cqe.res == -ECANCELED) op->result = 0;
+            done.push_back(op);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return keep_going;
+    }
+
+private:
+    static void prep(io_uring_sqe* sqe, uint8_t opcode, int fd, const void* addr, size_t len,
+                     int64_t off, uint64_t user_data) {
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(addr);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->off = static_cast<uint64_t>(off);  // -1 = current position
+        sqe->user_data = user_data;
+    }
+
+    // Submits what is queued unless n more SQEs fit
+    void reserve(unsigned n) {
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_entries_ - (pending_tail_ - head) < n) flush_sq(0);
+    }
+
+    io_uring_sqe* next_sqe() {
+        reserve(1);
+        unsigned idx = pending_tail_ & sq_mask_;
+        sq_array_[idx] = idx;
+        ++pending_tail_;
+        return &sqes_[idx];
+    }
+
+    int flush_sq(unsigned min_complete) {
+        // Count from the kernel's head so entries left over by an interrupted
+        // enter are submitted again
+        __atomic_store_n(sq_tail_, pending_tail_, __ATOMIC_RELEASE);
+        unsigned submitted = pending_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+        if (!submitted && !min_complete) return 0;
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_, submitted, min_complete,
+                                          flags, nullptr, 0));
+    }
+
+    void arm_wake() {
+        io_uring_sqe* sqe = next_sqe();
+        prep(sqe, IORING_OP_READ, wake_fd, &wake_buf_, sizeof(wake_buf_), -1, kWakeToken);
+    }
+
+    void teardown() {
+        if (sqes_ && sqes_ != MAP_FAILED) ::munmap(sqes_, sqes_size_);
+        if (cq_ptr_ && cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_size_);
+        if (sq_ptr_ && sq_ptr_ != MAP_FAILED) ::munmap(sq_ptr_, sq_size_);
+        sqes_ = nullptr;
+        sq_ptr_ = cq_ptr_ = nullptr;
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned *sq_head_ = nullptr, *sq_tail_ = nullptr, *sq_array_ = nullptr;
+    unsigned *cq_head_ = nullptr, *cq_tail_ = nullptr;
+    unsigned sq_mask_ = 0, cq_mask_ = 0, sq_entries_ = 0;
+    unsigned pending_tail_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    __kernel_timespec deadline_{};
+    uint64_t wake_buf_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// epoll fallback: readiness + nonblocking syscalls, timers in an intrusive heap
+
+class EpollImpl : public Reactor::Impl {
+public:
+    EpollImpl() {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ < 0 || wake_fd < 0) return;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wake_fd;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd, &ev);
+    }
+
+    ~EpollImpl() override {
+        if (epoll_fd_ >= 0) ::close(epoll_fd_);
+        if (wake_fd >= 0) ::close(wake_fd);
+    }
+
+    bool valid() const override { return epoll_fd_ >= 0 && wake_fd >= 0; }
+    Reactor::Backend backend() const override { return Reactor::Backend::Epoll; }
+
+    bool try_complete(IoOp& op) override {
+        switch (op.kind) {
+        case IoOp::Kind::Timeout:
+            if (monotonic_ns() < op.deadline_ns) return false;
+            op.result = 0;
+            return true;
+        case IoOp::Kind::Poll: {
+            pollfd pfd{op.fd, static_cast<short>(op.flags), 0};
+            if (::poll(&pfd, 1, 0) <= 0) return false;
+            op.result = pfd.revents;
+            return true;
+        }
+        default:
+            op.result = run_syscall(op);
+            return op.result != -EAGAIN;
+        }
+    }
+
+    void submit(IoOp& op) override {
+        if (op.kind == IoOp::Kind::Timeout) {
+            heap_push(&op);
+            return;
+        }
+
+        if (static_cast<size_t>(op.fd) >= waiters_.size()) waiters_.resize(op.fd + 1);
+        Waiters& w = waiters_[op.fd];
+        IoOp*& slot = wants_output(op) ? w.out : w.in;
+        assert(!slot && "one pending input and one pending output op per fd");
+        slot = &op;
+        if (!arm(op.fd, w)) {
+            // Not pollable (regular file): it was "ready" all along
+            slot = nullptr;
+            op.result = op.kind == IoOp::Kind::Poll ? op.flags : run_syscall(op);
+            ready_.push_back(&op);
+            return;
+        }
+        if (op.kind == IoOp::Kind::Poll && op.deadline_ns) heap_push(&op);
+    }
+
+    void cancel(IoOp& op) override {
+        if (op.heap_index != SIZE_MAX) heap_erase(&op);
+        if (op.kind != IoOp::Kind::Timeout && static_cast<size_t>(op.fd) < waiters_.size()) {
+            Waiters& w = waiters_[op.fd];
+            if (w.in == &op || w.out == &op) {
+                (w.in == &op ? w.in : w.out) = nullptr;
+                arm(op.fd, w);
+            }
+        }
+        if (std::find(ready_.begin(), ready_.end(), &op) != ready_.end()) return;
+        op.result = -ECANCELED;
+        ready_.push_back(&op);
+    }
+
+    bool wait(std::vector<IoOp*>& done) override {
+        if (!ready_.empty()) {
+            done.insert(done.end(), ready_.begin(), ready_.end());
+            ready_.clear();
+            return true;
+        }
+
+        int timeout_ms = -1;
+        if (!heap_.empty()) {
+            uint64_t now = monotonic_ns();
+            uint64_t next = heap_.front()->deadline_ns;
+            timeout_ms = next <= now ? 0 : static_cast<int>((next - now + 999999) / 1000000);
+        }
+
+        epoll_event events[32];
+        int n = ::epoll_wait(epoll_fd_, events, 32, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "Reactor: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        bool keep_going = true;
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd) {
+                uint64_t v;
+                while (::read(wake_fd, &v, sizeof(v)) > 0) {}
+                keep_going = false;
+                continue;
+            }
+            Waiters& w = waiters_[fd];
+            uint32_t revents = events[i].events;
+            w.armed = 0;  // EPOLLONESHOT disarmed the fd
+            if (w.in && (revents & (mask_of(*w.in) | EPOLLERR | EPOLLHUP))) {
+                complete(w.in, revents, done);
+            }
+            if (w.out && (revents & (mask_of(*w.out) | EPOLLERR | EPOLLHUP))) {
+                complete(w.out, revents, done);
+            }
+            // Re-arm for whatever is still waiting, including spurious wakeups
+            if (w.in || w.out) arm(fd, w);
+        }
+
+        uint64_t now = monotonic_ns();
+        while (!heap_.empty() && heap_.front()->deadline_ns <= now) {
+            IoOp* op = heap_.front();
+            heap_erase(op);
+            if (op->kind == IoOp::Kind::Poll) {
+                // Timed out: drop the fd interest so a later event can't fire
+                Waiters& w = waiters_[op->fd];
+                (w.in == op ? w.in : w.out) = nullptr;
+                arm(op->fd, w);
+            }
+            op->result = 0;
+            done.push_back(op);
+        }
+        return keep_going;
+    }
+
+private:
+    void heap_swap(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        heap_[a]->heap_index = a;
+        heap_[b]->heap_index = b;
+    }
+    void sift_up(size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap_[parent]->deadline_ns <= heap_[i]->deadline_ns) break;
+            heap_swap(i, parent);
+            i = parent;
+        }
+    }
+    void sift_down(size_t i) {
+        for (;;) {
+            size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < heap_.size() && heap_[l]->deadline_ns < heap_[m]->deadline_ns) m = l;
+            if (r < heap_.size() && heap_[r]->deadline_ns < heap_[m]->deadline_ns) m = r;
+            if (m == i) return;
+            heap_swap(i, m);
+            i = m;
+        }
+    }
+    void heap_push(IoOp* op) {
+        op->heap_index = heap_.size();
+        heap_.push_back(op);
+        sift_up(op->heap_index);
+    }
+    void heap_erase(IoOp* op) {
+        size_t i = op->heap_index;
+        heap_swap(i, heap_.size() - 1);
+        heap_.pop_back();
+        op->heap_index = SIZE_MAX;
+        if (i < heap_.size()) {
+            sift_up(i);
+            sift_down(i);
+        }
+    }
+
+    // Input side: Read, and Poll unless it waits for POLLOUT alone. Output
+    // side: Write, Send, Poll for POLLOUT. Both masks share one EPOLLONESHOT
+    // registration per fd.
+    struct Waiters {
+        IoOp* in = nullptr;
+        IoOp* out = nullptr;
+        uint32_t armed = 0;       // mask currently registered, 0 once fired
+        bool registered = false;  // fd is in the interest list
+    };
+
+    static bool wants_output(const IoOp& op) {
+        if (op.kind == IoOp::Kind::Poll) return (op.flags & POLLOUT) && !(op.flags & POLLIN);
+        return op.kind != IoOp::Kind::Read;
+    }
+    static uint32_t mask_of(const IoOp& op) {
+        if (op.kind == IoOp::Kind::Poll) return static_cast<uint32_t>(op.flags);
+        return op.kind == IoOp::Kind::Read ? EPOLLIN : EPOLLOUT;
+    }
+
+    // Registers the merged mask of w's waiters, or drops the fd when none
+    // are left. False if the fd can't be polled.
+    bool arm(int fd, Waiters& w) {
+        uint32_t mask = (w.in ? mask_of(*w.in) : 0) | (w.out ? mask_of(*w.out) : 0);
+        if (!mask) {
+            if (w.registered) ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            w.registered = false;
+            w.armed = 0;
+            return true;
+        }
+        if (mask == w.armed) return true;
+        epoll_event ev{};
+        ev.events = mask | EPOLLONESHOT;
+        ev.data.fd = fd;
+        // MOD first: the fd usually stays registered between operations. A
+        // closed and reused fd has silently left the interest list.
+        if (!(w.registered && ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0) &&
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            return false;
+        }
+        w.registered = true;
+        w.armed = mask;
+        return true;
+    }
+
+    // Finishes the op in `slot` unless the syscall would still block
+    void complete(IoOp*& slot, uint32_t revents, std::vector<IoOp*>& done) {
+        IoOp* op = slot;
+        if (op->kind == IoOp::Kind::Poll) {
+            op->result = revents & (mask_of(*op) | EPOLLERR | EPOLLHUP);
+        } else {
+            op->result = run_syscall(*op);
+            if (op->result == -EAGAIN) return;  // spurious wakeup: stays armed
+        }
+        if (op->heap_index != SIZE_MAX) heap_erase(op);
+        slot = nullptr;
+        done.push_back(op);
+    }
+
+    int epoll_fd_ = -1;
+    std::vector<Waiters> waiters_;  // by fd
+    std::vector<IoOp*> heap_;
+    std::vector<IoOp*> ready_;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+Reactor::Reactor(bool prefer_io_uring, unsigned queue_depth) {
+    spawned_.prev = spawned_.next = &spawned_;
+    if (prefer_io_uring) {
+        auto uring = std::make_unique<UringImpl>(queue_depth);
+        if (uring->valid()) impl_ = std::move(uring);
+    }
+    if (!impl_) impl_ = std::make_unique<EpollImpl>();
+}
+
+Reactor::~Reactor() {
+    if (pending_) {
+        for (IoOp* op = pending_; op; op = op->next) impl_->cancel(*op);
+        // Cancellation is asynchronous with io_uring: reap until every op has
+        // completed, giving up only if the backend stops producing any
+        std::vector<IoOp*> done;
+        for (int idle = 0; pending_ && idle < 100;) {
+            done.clear();
+            impl_->wait(done);
+            idle = done.empty() ? idle + 1 : 0;
+            for (IoOp* op : done) retire(*op);
+        }
+    }
+    while (spawned_.next != &spawned_) {
+        auto& promise = static_cast<detail::Promise<void>&>(*spawned_.next);
+        promise.unlink();
+        std::coroutine_handle<detail::Promise<void>>::from_promise(promise).destroy();
+    }
+}
+
+bool Reactor::valid() const { return impl_ && impl_->valid(); }
+Reactor::Backend Reactor::backend() const { return impl_->backend(); }
+const char* Reactor::backend_name() const {
+    return backend() == Backend::IoUring ? "io_uring" : "epoll";
+}
+
+IoAwaitable Reactor::read(int fd, void* buf, size_t len, int64_t offset) {
+    IoOp op;
+    op.kind = IoOp::Kind::Read;
+    op.fd = fd;
+    op.buf = buf;
+    op.len = len;
+    op.offset = offset;
+    return IoAwaitable(this, op);
+}
+
+IoAwaitable Reactor::write(int fd, const void* buf, size_t len, int64_t offset) {
+    IoOp op;
+    op.kind = IoOp::Kind::Write;
+    op.fd = fd;
+    op.buf = const_cast<void*>(buf);
+    op.len = len;
+    op.offset = offset;
+    return IoAwaitable(this, op);
+}
+
+IoAwaitable Reactor::send(int fd, const void* buf, size_t len, int flags) {
+    IoOp op;
+    op.kind = IoOp::Kind::Send;
+    op.fd = fd;
+    op.buf = const_cast<void*>(buf);
+    op.len = len;
+    op.flags = flags;
+    return IoAwaitable(this, op);
+}
+
+IoAwaitable Reactor::poll(int fd, short events, std::chrono::nanoseconds timeout) {
+    IoOp op;
+    op.kind = IoOp::Kind::Poll;
+    op.fd = fd;
+    op.flags = events;
+    op.deadline_ns = monotonic_ns() + static_cast<uint64_t>(timeout.count());
+    return IoAwaitable(this, op);
+}
+
+IoAwaitable Reactor::sleep_until(uint64_t deadline_ns) {
+    IoOp op;
+    op.kind = IoOp::Kind::Timeout;
+    op.deadline_ns = deadline_ns;
+    return IoAwaitable(this, op);
+}
+
+IoAwaitable Reactor::sleep_for(std::chrono::nanoseconds d) {
+    return sleep_until(monotonic_ns() + static_cast<uint64_t>(d.count()));
+}
+
+void Reactor::spawn(AsyncTask<void> task) {
+    auto handle = task.release();
+    if (!handle) return;
+    auto& promise = handle.promise();
+    promise.detached = true;
+    promise.prev = &spawned_;
+    promise.next = spawned_.next;
+    spawned_.next->prev = &promise;
+    spawned_.next = &promise;
+    handle.resume();
+}
+
+bool Reactor::try_complete(IoOp& op) { return impl_->try_complete(op); }
+
+void Reactor::submit(IoOp& op) {
+    ++in_flight_;
+    op.prev = nullptr;
+    op.next = pending_;
+    if (pending_) pending_->prev = &op;
+    pending_ = &op;
+    impl_->submit(op);
+}
+
+// Takes a completed op off the in-flight list; repeats are ignored
+void Reactor::retire(IoOp& op) {
+    if (pending_ != &op && !op.prev) return;
+    if (op.prev) op.prev->next = op.next;
+    else pending_ = op.next;
+    if (op.next) op.next->prev = op.prev;
+    op.prev = op.next = nullptr;
+    --in_flight_;
+}
+
+void Reactor::run() {
+    std::vector<IoOp*> done;
+    done.reserve(64);
+    while (in_flight_ > 0) {
+        done.clear();
+        bool keep_going = impl_->wait(done);
+        for (IoOp* op : done) retire(*op);
+        for (IoOp* op : done) op->handle.resume();
+        if (!keep_going) break;
+    }
+}
+
+void Reactor::stop() {
+    uint64_t one = 1;
+    ssize_t n = ::write(impl_->wake_fd, &one, sizeof(one));
+    (void)n;
+}
+
+bool IoAwaitable::await_ready() { return reactor_->try_complete(op_); }
+
+void IoAwaitable::await_suspend(std::coroutine_handle<> h) {
+    op_.handle = h;
+    reactor_->submit(op_);
+}
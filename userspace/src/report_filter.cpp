@@ -0,0 +1,170 @@
+#include "report_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Negative when `to` precedes `from`
+double seconds_between(uint64_t from, uint64_t to) {
+    return to >= from ? static_cast<double>(to - from) / 1e9
+                      : -static_cast<double>(from - to) / 1e9;
+}
+}
+
+ReportFilter::ReportFilter(const ReportFilterConfig& config)
+    : config_(config), bands_{config.temperature, config.humidity} {
+    reset();
+}
+
+void ReportFilter::reset() {
+    have_anchor_ = false;
+    have_pending_ = false;
+    have_prev_ = false;
+    prev_flags_ = 0;
+    samples_in_ = 0;
+    samples_out_ = 0;
+    restart_doors(Sample{});
+}
+
+float ReportFilter::deadband(int channel, float reference) const {
+    return std::max(bands_[channel].absolute, bands_[channel].relative * std::fabs(reference));
+}
+
+bool ReportFilter::exceeds_deadband(const Sample& s) const {
+    for (int c = 0; c < kChannels; ++c) {
+        if (std::fabs(s.value[c] - anchor_.value[c]) > deadband(c, anchor_.value[c])) return true;
+    }
+    return false;
+}
+
+void ReportFilter::restart_doors(const Sample& anchor) {
+    anchor_ = anchor;
+    have_pending_ = false;
+    for (int c = 0; c < kChannels; ++c) {
+        min_up_[c] = kInf;
+        max_low_[c] = -kInf;
+    }
+}
+
+// The point reported for a trend corner: the held sample moved onto the
+// slope range every sample since the anchor agrees with, so interpolating
+// anchor -> corner stays within each sample's deadband.
+ReportFilter::Sample ReportFilter::door_point(const Sample& p) const {
+    Sample corner = p;
+    double dt = seconds_between(anchor_.timestamp, p.timestamp);
+    if (dt <= 0.0) return corner;
+    for (int c = 0; c < kChannels; ++c) {
+        double slope = (p.value[c] - anchor_.value[c]) / dt;
+        slope = std::min(std::max(slope, max_low_[c]), min_up_[c]);
+        corner.value[c] = static_cast<float>(anchor_.value[c] + slope * dt);
+    }
+    return corner;
+}
+
+void ReportFilter::emit(const Sample& s, SensorBatch& out) {
+    uint32_t i = out.count++;
+    out.timestamp[i] = s.timestamp;
+    out.temperature[i] = s.value[0];
+    out.humidity[i] = s.value[1];
+    out.flags[i] = s.flags;
+    ++samples_out_;
+}
+
+void ReportFilter::process(const Sample& s, SensorBatch& out) {
+    ++samples_in_;
+    bool edge = have_prev_ && s.flags != prev_flags_;
+    prev_flags_ = s.flags;
+    have_prev_ = true;
+
+    // A clock that steps back (replay loop, source restart) re-anchors
+    // rather than feeding a wrapped interval to the heartbeat and doors.
+    bool backwards = have_anchor_ && s.timestamp < anchor_.timestamp;
+    bool heartbeat = !backwards && config_.max_silence_ns != 0 &&
+                     s.timestamp - anchor_.timestamp >= config_.max_silence_ns;
+
+    if (!have_anchor_ || edge || heartbeat || backwards) {
+        // Close any open trend at the held point first, so the reported
+        // series still brackets every sample before the forced report.
+        if (have_pending_) emit(door_point(pending_), out);
+        emit(s, out);
+        restart_doors(s);
+        have_anchor_ = true;
+        return;
+    }
+
+    if (config_.mode == ReportFilterConfig::Mode::Deadband) {
+        if (exceeds_deadband(s)) {
+            emit(s, out);
+            restart_doors(s);
+        }
+        return;
+    }
+
+    // Swinging door: narrow each channel's admissible slope range; when any
+    // range becomes empty, the held sample is a trend corner.
+    double dt = seconds_between(anchor_.timestamp, s.timestamp);
+    double low[kChannels], up[kChannels];
+    bool open = true;
+    for (int c = 0; c < kChannels; ++c) {
+        double dev = deadband(c, anchor_.value[c]);
+        double diff = s.value[c] - anchor_.value[c];
+        if (dt <= 0.0) {
+            // Same instant as the anchor: admissible only inside the deadband
+            low[c] = max_low_[c];
+            up[c] = min_up_[c];
+            if (std::fabs(diff) > dev) open = false;
+            continue;
+        }
+        low[c] = std::max(max_low_[c], (diff - dev) / dt);
+        up[c] = std::min(min_up_[c], (diff + dev) / dt);
+        if (low[c] > up[c]) open = false;
+    }
+
+    if (open) {
+        for (int c = 0; c < kChannels; ++c) {
+            max_low_[c] = low[c];
+            min_up_[c] = up[c];
+        }
+        pending_ = s;
+        have_pending_ = true;
+        return;
+    }
+
+    if (!have_pending_) {
+        // Nothing held (s follows the anchor directly): s is the corner.
+        emit(s, out);
+        restart_doors(s);
+        return;
+    }
+
+    Sample corner = door_point(pending_);
+    emit(corner, out);
+    restart_doors(corner);
+    // Re-evaluate s against the new anchor; a single sample always fits.
+    process(s, out);
+    --samples_in_;
+}
+
+uint32_t ReportFilter::filter(const SensorBatch& in, uint32_t from, SensorBatch& out) {
+    uint32_t i = from;
+    // One input sample can report at most two points (held corner + itself)
+    for (; i < in.count && out.count + 2 <= SensorBatch::kCapacity; ++i) {
+        Sample s;
+        s.timestamp = in.timestamp[i];
+        s.value[0] = in.temperature[i];
+        s.value[1] = in.humidity[i];
+        s.flags = in.flags[i];
+        process(s, out);
+    }
+    return i;
+}
+
+void ReportFilter::flush(SensorBatch& out) {
+    if (!have_pending_ || out.full()) return;
+    Sample corner = door_point(pending_);
+    emit(corner, out);
+    restart_doors(corner);
+}
@@ -0,0 +1,33 @@
+#include "sensor_batch.h"
+
+SensorBatchPool::SensorBatchPool(size_t batches)
+    : capacity_(batches), storage_(new SensorBatch[batches]) {
+    free_.reserve(batches);
+    for (size_t i = 0; i < batches; ++i) {
+        storage_[i].pool_ = this;
+        free_.push_back(&storage_[i]);
+    }
+}
+
+BatchHandle SensorBatchPool::acquire() {
+    SensorBatch* batch = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        if (free_.empty()) return BatchHandle();
+        batch = free_.back();
+        free_.pop_back();
+    }
+    batch->clear();
+    batch->refs_.store(1, std::memory_order_relaxed);
+    return BatchHandle(batch);
+}
+
+size_t SensorBatchPool::available() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return free_.size();
+}
+
+void SensorBatchPool::release(SensorBatch* batch) {
+    std::lock_guard<std::mutex> lock(m_);
+    free_.push_back(batch);
+}
@@ -1,55 +1,69 @@
 #include "sensor_manager.h"
 #include "config.h"
+#include "fixed_point.h"
+#include "trace.h"
 
-#include <cerrno>
-#include <cstring>
-#include <fcntl.h>
 #include <iostream>
-#include <stdexcept>
-#include <sys/ioctl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
-namespace {
-// Mirror of the kernel’s struct sensor_data in sensorhub_driver.c
-struct KernelSensorData {
-    float temperature;
-    float humidity;
-    int motion_detected;
-    int button_pressed;
-    unsigned long timestamp;
-};
-
-// Ioctl command used in the kernel driver (0x01: reset data_ready)
-constexpr unsigned int SENSORHUB_IOCTL_RESET = 0x01;
-}
-
 SensorManager::SensorManager()
-    : device_fd_(-1), initialized_(false), running_(false) {}
+    : SensorManager(std::make_unique<DeviceSensorSource>(DEVICE_PATH)) {}
 
-SensorManager::~SensorManager() { shutdown(); }
+SensorManager::SensorManager(std::unique_ptr<SensorSource> source)
+    : source_(std::move(source)), initialized_(false), running_(false),
+      source_finished_(false), sequence_(0), loop_active_(false),
+      pool_(SENSOR_BATCH_POOL_SIZE), ready_(SENSOR_BATCH_POOL_SIZE),
+      current_opened_ns_(0),
+      flush_interval_(std::chrono::milliseconds(SENSOR_BATCH_FLUSH_MS)),
+      dropped_samples_(0),
+      batch_event_fd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
 
-bool SensorManager::initialize() {
-    if (initialized_) return true;
+SensorManager::~SensorManager() {
+    shutdown();
+    if (batch_event_fd_ >= 0) ::close(batch_event_fd_);
+}
 
-    device_fd_ = ::open(DEVICE_PATH, O_RDONLY | O_NONBLOCK);
-    if (device_fd_ < 0) {
-        std::cerr << "Failed to open sensorhub device " << DEVICE_PATH
-                  << ": " << std::strerror(errno) << std::endl;
+bool SensorManager::open_source() {
+    if (!source_ || !source_->open()) {
         return false;
     }
+    running_ = true;
+    source_finished_ = false;
+    return true;
+}
 
-    // Clear any stale readiness flag
-    ::ioctl(device_fd_, SENSORHUB_IOCTL_RESET, 0);
+bool SensorManager::initialize() {
+    if (initialized_) return true;
+    if (!open_source()) return false;
 
-    running_ = true;
     update_thread_ = std::thread(&SensorManager::update_thread, this);
     initialized_ = true;
 
-    std::cout << "SensorManager initialized (device=" << DEVICE_PATH << ")"
+    std::cout << "SensorManager initialized (source=" << source_->name() << ")"
               << std::endl;
     return true;
 }
 
+bool SensorManager::initialize(Reactor& reactor) {
+    if (initialized_) return true;
+    if (!open_source()) return false;
+
+    loop_active_ = true;
+    initialized_ = true;
+    reactor.spawn(update_loop(reactor));
+
+    std::cout << "SensorManager initialized (source=" << source_->name()
+              << ", reactor=" << reactor.backend_name() << ")" << std::endl;
+    return true;
+}
+
+bool SensorManager::enable_shm_channel(const std::string& name, uint32_t capacity) {
+    if (initialized_) return false;
+    return shm_.open(name, capacity);
+}
+
 void SensorManager::shutdown() {
     running_ = false;
 
@@ -57,56 +71,193 @@ void SensorManager::shutdown() {
         update_thread_.join();
     }
 
-    if (device_fd_ >= 0) {
-        ::close(device_fd_);
-        device_fd_ = -1;
+    // A reactor-driven loop closes the source itself once it notices
+    if (!loop_active_) close_source();
+}
+
+void SensorManager::close_source() {
+    // Both shutdown() and a finishing update_loop() may get here
+    if (!initialized_.exchange(false)) return;
+    if (source_) {
+        source_->close();
     }
 
-    initialized_ = false;
     std::cout << "SensorManager shutdown" << std::endl;
 }
 
+namespace {
+SensorData to_sensor_data(const SensorSample& s) {
+    SensorData d;
+    d.temperature = fixed::from_milli(s.temperature_milli);
+    d.humidity = fixed::from_milli(s.humidity_milli);
+    d.motion_detected = (s.flags & SENSOR_FLAG_MOTION) ? 1 : 0;
+    d.button_pressed = (s.flags & SENSOR_FLAG_BUTTON) ? 1 : 0;
+    d.timestamp = s.timestamp;
+    return d;
+}
+}
+
 SensorData SensorManager::read_sensors() {
     std::lock_guard<std::mutex> lock(data_mutex_);
-    return last_reading_;
+    return to_sensor_data(last_sample_);
 }
 
-bool SensorManager::read_from_device(SensorData& data) {
-    if (device_fd_ < 0) return false;
+bool SensorManager::wait_for_update(SensorData& data, uint64_t& seq,
+                                    std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(data_mutex_);
+    if (!data_cv_.wait_for(lock, timeout, [&] { return sequence_ != seq; })) {
+        return false;
+    }
+    data = to_sensor_data(last_sample_);
+    seq = sequence_;
+    return true;
+}
 
-    KernelSensorData kdata{};
-    ssize_t bytes_read = ::read(device_fd_, &kdata, sizeof(kdata));
+bool SensorManager::wait_for_batch(BatchHandle& batch,
+                                   std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(data_mutex_);
+    data_cv_.wait_for(lock, timeout, [&] {
+        return ready_.size() > 0 || source_finished_;
+    });
+    auto next = ready_.pop();
+    if (!next) return false;
+    batch = std::move(*next);
+    return true;
+}
+
+void SensorManager::append_sample(const SensorSample& sample) {
+    if (!current_) {
+        current_ = pool_.acquire();
+        if (!current_) {
+            // Every batch is still held downstream; shed load, don't allocate
+            ++dropped_samples_;
+            return;
+        }
+        current_->first_seq = sequence_;
+        current_opened_ns_ = monotonic_ns();
+    }
+    uint32_t i = current_->count++;
+    current_->timestamp[i] = sample.timestamp;
+    current_->flags[i] = sample.flags;
+    staged_temperature_[i] = sample.temperature_milli;
+    staged_humidity_[i] = sample.humidity_milli;
+    if (current_->full()) publish_batch();
+}
+
+void SensorManager::publish_batch() {
+    if (!current_ || current_->empty()) return;
+    TRACE_SCOPE("sensor.publish_batch", current_->first_seq);
+    trace::flow("sample", trace::Phase::FlowStart, current_->first_seq);
+    // The float edge: each value column converted in one vector pass
+    fixed::milli_to_float(staged_temperature_, current_->temperature, current_->count);
+    fixed::milli_to_float(staged_humidity_, current_->humidity, current_->count);
+    shm_.publish(*current_);
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        // Cannot overflow: the ring holds as many entries as the pool has batches
+        ready_.push(current_);
+    }
+    current_.reset();
+    data_cv_.notify_all();
+    uint64_t one = 1;
+    ssize_t n = ::write(batch_event_fd_, &one, sizeof(one));
+    (void)n;
+}
 
-    if (bytes_read == sizeof(kdata)) {
-        data.temperature = kdata.temperature;
-        data.humidity = kdata.humidity;
-        data.motion_detected = kdata.motion_detected;
-        data.button_pressed = kdata.button_pressed;
-        data.timestamp = kdata.timestamp;
-        return true;
+int SensorManager::source_timeout_ms() const {
+    // Never sleep past the flush deadline of a partially filled batch
+    int timeout_ms = 50;
+    if (current_) {
+        uint64_t age_ms = (monotonic_ns() - current_opened_ns_) / 1000000ull;
+        int64_t left = flush_interval_.load().count() - static_cast<int64_t>(age_ms);
+        if (left < timeout_ms) timeout_ms = left > 0 ? static_cast<int>(left) : 0;
     }
+    return timeout_ms;
+}
+
+void SensorManager::wait_for_source() {
+    TRACE_SCOPE("sensor.wait_source", sequence_);
+    int timeout_ms = source_timeout_ms();
+    int fd = source_->wait_fd();
+    if (fd < 0) {
+        // Avoid busy-spin on EAGAIN/EINTR
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return;
+    }
+    pollfd pfd{fd, POLLIN, 0};
+    ::poll(&pfd, 1, timeout_ms);
+}
 
-    if (bytes_read < 0 && (errno == EAGAIN || errno == EINTR)) {
-        return false; // non-fatal, just try again
+SensorManager::Step SensorManager::step() {
+    SensorSample sample;
+    if (source_->read(sample)) {
+        trace::instant("sensor.sample", sequence_ + 1);
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            last_sample_ = sample;
+            ++sequence_;
+        }
+        data_cv_.notify_all();
+        append_sample(sample);
+        return Step::Sample;
+    }
+    if (source_->finished()) {
+        publish_batch();
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            source_finished_ = true;
+        }
+        data_cv_.notify_all();
+        return Step::Finished;
     }
+    return Step::Idle;
+}
 
-    // Any other short read or error is unexpected
-    std::cerr << "SensorManager read error: " << std::strerror(errno) << std::endl;
-    return false;
+void SensorManager::flush_if_due() {
+    if (current_ && monotonic_ns() - current_opened_ns_ >=
+            static_cast<uint64_t>(flush_interval_.load().count()) * 1000000ull) {
+        publish_batch();
+    }
 }
 
 void SensorManager::update_thread() {
+    trace::set_thread_name("sensor_update");
+
     // Block until data arrives; driver wakes readers via wait queue
     while (running_) {
-        SensorData new_data;
-        if (read_from_device(new_data)) {
-            std::lock_guard<std::mutex> lock(data_mutex_);
-            last_reading_ = new_data;
-        } else {
-            // Avoid busy-spin on EAGAIN/EINTR
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Step s = step();
+        if (s == Step::Finished) break;
+        if (s == Step::Idle) wait_for_source();
+        flush_if_due();
+    }
+    // Samples already read must reach the consumers, as on Finished
+    publish_batch();
+    current_.reset();
+}
+
+AsyncTask<> SensorManager::update_loop(Reactor& reactor) {
+    // Same loop as update_thread(), with the waits handed to the reactor
+    while (running_) {
+        Step s = step();
+        if (s == Step::Finished) break;
+        if (s == Step::Idle) {
+            // Scopes must not span a suspension: other tasks share this thread
+            trace::instant("sensor.wait_source", sequence_);
+            auto timeout = std::chrono::milliseconds(source_timeout_ms());
+            int fd = source_->wait_fd();
+            if (fd >= 0) {
+                co_await reactor.poll(fd, POLLIN, timeout);
+            } else {
+                co_await reactor.sleep_for(timeout);
+            }
         }
+        flush_if_due();
     }
+    // Samples already read must reach the consumers, as on Finished
+    publish_batch();
+    current_.reset();
+    loop_active_ = false;
+    if (!running_) close_source();
 }
 
 void SensorManager::check_alerts() {
@@ -128,3 +279,28 @@ void SensorManager::check_alerts() {
         std::cout << "ALERT: Button pressed!" << std::endl;
     }
 }
+
+void SensorManager::check_alerts(const SensorBatch& batch) {
+    TRACE_SCOPE("alerts.check_batch", batch.first_seq);
+    trace::flow("sample", trace::Phase::FlowEnd, batch.first_seq);
+    // One line per condition per batch, reporting the first offending sample
+    bool temp = false, hum = false, motion = false, button = false;
+    for (uint32_t i = 0; i < batch.count; ++i) {
+        if (!temp && batch.temperature[i] > TEMPERATURE_ALERT_THRESHOLD) {
+            std::cout << "ALERT: High temperature: " << batch.temperature[i] << " C" << std::endl;
+            temp = true;
+        }
+        if (!hum && batch.humidity[i] > HUMIDITY_ALERT_THRESHOLD) {
+            std::cout << "ALERT: High humidity: " << batch.humidity[i] << " %" << std::endl;
+            hum = true;
+        }
+        if (!motion && (batch.flags[i] & SENSOR_FLAG_MOTION)) {
+            std::cout << "ALERT: Motion detected!" << std::endl;
+            motion = true;
+        }
+        if (!button && (batch.flags[i] & SENSOR_FLAG_BUTTON)) {
+            std::cout << "ALERT: Button pressed!" << std::endl;
+            button = true;
+        }
+    }
+}
@@ -2,33 +2,92 @@
 #define SENSOR_MANAGER_H
 
 #include "common.h"
+#include "sensor_batch.h"
+#include "sensor_source.h"
+#include "reactor.h"
+#include "shm_channel.h"
+#include "RingBuffer.hpp"
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <thread>
 #include <mutex>
 
 class SensorManager {
 public:
     SensorManager();
+    explicit SensorManager(std::unique_ptr<SensorSource> source);
     ~SensorManager();
     
     bool initialize();
+    // Runs the update loop as a coroutine on `reactor` instead of a thread.
+    // shutdown() then only asks it to stop; keep the reactor running until
+    // the loop has exited (at most one poll interval later).
+    bool initialize(Reactor& reactor);
     void shutdown();
     
     SensorData read_sensors();
+    // Blocks until a reading newer than `seq` arrives (or timeout); on success
+    // updates `seq` so the caller can count readings it never saw.
+    bool wait_for_update(SensorData& data, uint64_t& seq,
+                         std::chrono::milliseconds timeout);
+    // Next published batch, oldest first. Batches are published when full or
+    // once the oldest sample in them is older than the flush interval.
+    bool wait_for_batch(BatchHandle& batch, std::chrono::milliseconds timeout);
+    // Eventfd (nonblocking) that becomes readable when batches are published;
+    // reactor-driven consumers await it and drain with a zero timeout above.
+    int batch_event_fd() const { return batch_event_fd_; }
+    void set_batch_flush_interval(std::chrono::milliseconds interval) { flush_interval_ = interval; }
+    // Also publish every batch into shared-memory ring `name` for local
+    // reader processes (pirtos_shm.h). Call before initialize().
+    bool enable_shm_channel(const std::string& name, uint32_t capacity);
+    // Samples lost because every pooled batch was still held downstream
+    uint64_t samples_dropped() const { return dropped_samples_; }
+
     void check_alerts();
+    void check_alerts(const SensorBatch& batch);
     bool is_initialized() const { return initialized_; }
+    bool source_finished() const { return source_finished_; }
+    uint64_t samples_received() const { return sequence_; }
     
 private:
+    enum class Step { Sample, Idle, Finished };
+
+    bool open_source();
+    void close_source();
     void update_thread();
-    bool read_from_device(SensorData& data);
+    AsyncTask<> update_loop(Reactor& reactor);
+    Step step();
+    int source_timeout_ms() const;
+    void flush_if_due();
+    void wait_for_source();
+    void append_sample(const SensorSample& sample);
+    void publish_batch();
     
-    int device_fd_;
+    std::unique_ptr<SensorSource> source_;
     std::atomic<bool> initialized_;
     std::atomic<bool> running_;
+    std::atomic<bool> source_finished_;
+    std::atomic<uint64_t> sequence_;
     std::thread update_thread_;
+    std::atomic<bool> loop_active_;    // update_loop() still on the reactor
     std::mutex data_mutex_;
-    SensorData last_reading_;
+    std::condition_variable data_cv_;
+    SensorSample last_sample_;
+
+    SensorBatchPool pool_;
+    RingBuffer<BatchHandle> ready_;
+    BatchHandle current_;              // owned by the update thread
+    // current_'s value columns in fixed point until publish_batch()
+    alignas(64) int32_t staged_temperature_[SensorBatch::kCapacity];
+    alignas(64) int32_t staged_humidity_[SensorBatch::kCapacity];
+    uint64_t current_opened_ns_;
+    std::atomic<std::chrono::milliseconds> flush_interval_;
+    std::atomic<uint64_t> dropped_samples_;
+    int batch_event_fd_;
+    ShmPublisher shm_;                 // written by the update thread only
 };
 
 #endif // SENSOR_MANAGER_H
@@ -0,0 +1,303 @@
+#include "sensor_source.h"
+#include "fixed_point.h"
+#include "sensorhub_driver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+static_assert(sizeof(sensorhub_sample) == 32, "driver record layout changed");
+static_assert(SENSORHUB_FLAG_MOTION == SENSOR_FLAG_MOTION &&
+              SENSORHUB_FLAG_BUTTON == SENSOR_FLAG_BUTTON, "driver flags mirror SensorFlag");
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586;
+
+int create_timer() {
+    return ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+// One-shot absolute wakeup on the steady_clock (CLOCK_MONOTONIC) timeline.
+void arm_timer(int fd, uint64_t deadline_ns) {
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(deadline_ns / 1000000000ull);
+    spec.it_value.tv_nsec = static_cast<long>(deadline_ns % 1000000000ull);
+    ::timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void drain_timer(int fd) {
+    uint64_t expirations;
+    while (::read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+    }
+}
+}
+
+// ---------------------------------------------------------------------------
+// DeviceSensorSource
+
+DeviceSensorSource::DeviceSensorSource(std::string path)
+    : path_(std::move(path)), fd_(-1) {}
+
+bool DeviceSensorSource::open() {
+    if (fd_ >= 0) return true;
+
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open sensorhub device " << path_
+                  << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Refuse to start on a driver serving another record layout; drivers
+    // older than the ioctl predate the versioned record altogether
+    int version = 0;
+    if (::ioctl(fd_, SENSORHUB_GET_ABI_VERSION, &version) < 0 || version != SENSORHUB_ABI_VERSION) {
+        std::cerr << "sensorhub driver record version " << version << ", expected "
+                  << SENSORHUB_ABI_VERSION << "; load the matching driver" << std::endl;
+        close();
+        return false;
+    }
+
+    // Clear any stale readiness flag
+    ::ioctl(fd_, SENSORHUB_RESET_DATA, 0);
+    return true;
+}
+
+void DeviceSensorSource::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool DeviceSensorSource::read(SensorSample& sample) {
+    if (fd_ < 0) return false;
+
+    sensorhub_sample record{};
+    ssize_t bytes_read = ::read(fd_, &record, sizeof(record));
+
+    if (bytes_read == sizeof(record)) {
+        // open() checked the driver, which cannot be unloaded while we hold it
+        if (record.version != SENSORHUB_ABI_VERSION) return false;
+        sample.timestamp = record.timestamp_ns;
+        sample.temperature_milli = record.temp_milli_c;
+        sample.humidity_milli = record.humidity_milli_pct;
+        sample.flags = record.flags & (SENSOR_FLAG_MOTION | SENSOR_FLAG_BUTTON);
+        return true;
+    }
+
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return false; // non-fatal, just try again
+    }
+
+    // Any other short read or error is unexpected
+    std::cerr << "SensorManager read error: " << std::strerror(errno) << std::endl;
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// SyntheticSensorSource
+
+SyntheticSensorSource::SyntheticSensorSource(const SyntheticConfig& config)
+    : config_(config), timer_fd_(-1), start_ns_(0), emitted_(0),
+      armed_for_(0), motion_(0), rng_(config.seed) {}
+
+bool SyntheticSensorSource::open() {
+    if (timer_fd_ >= 0) return true;
+    if (config_.rate_hz <= 0.0) {
+        std::cerr << "Synthetic source: rate must be positive" << std::endl;
+        return false;
+    }
+    if (config_.burst_size == 0) config_.burst_size = 1;
+
+    timer_fd_ = create_timer();
+    if (timer_fd_ < 0) {
+        std::cerr << "Synthetic source: timerfd_create failed: "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+    start_ns_ = monotonic_ns();
+    emitted_ = 0;
+    armed_for_ = 0;
+    return true;
+}
+
+void SyntheticSensorSource::close() {
+    if (timer_fd_ >= 0) {
+        ::close(timer_fd_);
+        timer_fd_ = -1;
+    }
+}
+
+bool SyntheticSensorSource::finished() const {
+    return config_.max_samples != 0 && emitted_ >= config_.max_samples;
+}
+
+uint64_t SyntheticSensorSource::due_ns(uint64_t index) const {
+    if (config_.pattern == SyntheticConfig::Pattern::Burst) {
+        index -= index % config_.burst_size;
+    }
+    return start_ns_ + static_cast<uint64_t>(index * (1e9 / config_.rate_hz));
+}
+
+bool SyntheticSensorSource::read(SensorSample& sample) {
+    if (timer_fd_ < 0 || finished()) return false;
+
+    uint64_t due = due_ns(emitted_);
+    if (monotonic_ns() < due) {
+        if (armed_for_ != due) {
+            drain_timer(timer_fd_);
+            arm_timer(timer_fd_, due);
+            armed_for_ = due;
+        }
+        return false;
+    }
+
+    // Slow diurnal-style drift plus a little noise, so downstream stages see
+    // realistic, mostly-stable values.
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    double t = (due - start_ns_) / 1e9;
+    sample.temperature_milli = fixed::to_milli(
+        static_cast<float>(22.0 + 2.0 * std::sin(kTwoPi * t / 600.0)) + noise(rng_));
+    sample.humidity_milli = fixed::to_milli(
+        static_cast<float>(50.0 + 5.0 * std::sin(kTwoPi * t / 900.0)) + noise(rng_));
+
+    sample.flags = 0;
+    if (config_.event_rate_hz > 0.0) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        double p = config_.event_rate_hz / config_.rate_hz;
+        if (uniform(rng_) < p) motion_ = !motion_;
+        if (uniform(rng_) < p / 2.0) sample.flags |= SENSOR_FLAG_BUTTON;
+    }
+    if (motion_) sample.flags |= SENSOR_FLAG_MOTION;
+    sample.timestamp = due;
+
+    ++emitted_;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ReplaySensorSource
+
+ReplaySensorSource::ReplaySensorSource(std::string path, bool realtime, bool loop)
+    : path_(std::move(path)), realtime_(realtime), loop_(loop), timer_fd_(-1),
+      next_(0), start_ns_(0), pass_offset_ns_(0), armed_for_(0) {}
+
+bool ReplaySensorSource::open() {
+    std::ifstream in(path_);
+    if (!in) {
+        std::cerr << "Replay source: cannot open " << path_ << std::endl;
+        return false;
+    }
+
+    records_.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        unsigned long long ts = 0;
+        float temperature, humidity;
+        int motion, button;
+        if (std::sscanf(line.c_str(), "%llu,%f,%f,%d,%d", &ts, &temperature, &humidity,
+                        &motion, &button) != 5) {
+            std::cerr << "Replay source: skipping malformed line: " << line << std::endl;
+            continue;
+        }
+        // Captures stay human-readable; samples go fixed point on load
+        SensorSample rec;
+        rec.timestamp = ts;
+        rec.temperature_milli = fixed::to_milli(temperature);
+        rec.humidity_milli = fixed::to_milli(humidity);
+        rec.flags = static_cast<uint8_t>((motion ? SENSOR_FLAG_MOTION : 0) |
+                                         (button ? SENSOR_FLAG_BUTTON : 0));
+        records_.push_back(rec);
+    }
+    if (records_.empty()) {
+        std::cerr << "Replay source: no records in " << path_ << std::endl;
+        return false;
+    }
+
+    // Pacing and looping measure from the first record, so the capture must
+    // be in time order; merged or hand-edited captures may not be
+    size_t backwards = 0;
+    for (size_t i = 1; i < records_.size(); ++i) {
+        if (records_[i].timestamp < records_[i - 1].timestamp) ++backwards;
+    }
+    if (backwards) {
+        std::cerr << "Replay source: " << backwards << " records in " << path_
+                  << " go back in time; replaying in timestamp order" << std::endl;
+        std::stable_sort(records_.begin(), records_.end(),
+                         [](const SensorSample& a, const SensorSample& b) {
+                             return a.timestamp < b.timestamp;
+                         });
+    }
+
+    if (realtime_ && timer_fd_ < 0) {
+        timer_fd_ = create_timer();
+        if (timer_fd_ < 0) {
+            std::cerr << "Replay source: timerfd_create failed: "
+                      << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    next_ = 0;
+    start_ns_ = monotonic_ns();
+    pass_offset_ns_ = 0;
+    armed_for_ = 0;
+    return true;
+}
+
+void ReplaySensorSource::close() {
+    if (timer_fd_ >= 0) {
+        ::close(timer_fd_);
+        timer_fd_ = -1;
+    }
+}
+
+bool ReplaySensorSource::finished() const {
+    return !loop_ && next_ >= records_.size();
+}
+
+bool ReplaySensorSource::read(SensorSample& sample) {
+    if (records_.empty() || finished()) return false;
+
+    if (next_ >= records_.size()) {
+        // Loop: the next pass starts one mean interval after the last record.
+        uint64_t span = records_.back().timestamp - records_.front().timestamp;
+        uint64_t gap = records_.size() > 1 ? span / (records_.size() - 1) : 1000000;
+        pass_offset_ns_ += span + gap;
+        next_ = 0;
+    }
+
+    const SensorSample& rec = records_[next_];
+    uint64_t now = monotonic_ns();
+    uint64_t stamp = now;
+
+    if (realtime_) {
+        uint64_t due = start_ns_ + pass_offset_ns_ +
+                       (rec.timestamp - records_.front().timestamp);
+        if (now < due) {
+            if (armed_for_ != due) {
+                drain_timer(timer_fd_);
+                arm_timer(timer_fd_, due);
+                armed_for_ = due;
+            }
+            return false;
+        }
+        stamp = due;
+    }
+
+    sample = rec;
+    sample.timestamp = stamp;
+    ++next_;
+    return true;
+}
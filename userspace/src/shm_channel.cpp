@@ -0,0 +1,120 @@
+#include "shm_channel.h"
+#include "trace.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t round_up_pow2(uint32_t n) {
+    uint32_t p = 8;
+    while (p < n && p < (1u << 30)) p <<= 1;
+    return p;
+}
+
+// Marks a ring that is about to be unlinked so mapped readers reopen
+void retire(int fd) {
+    void* p = ::mmap(nullptr, PIRTOS_SHM_HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return;
+    auto* h = static_cast<pirtos_shm_header*>(p);
+    __atomic_store_n(&h->epoch, PIRTOS_SHM_EPOCH_RETIRED, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&h->futex, 1, __ATOMIC_SEQ_CST);
+    ::syscall(SYS_futex, &h->futex, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    ::munmap(p, PIRTOS_SHM_HEADER_BYTES);
+}
+
+}
+
+bool ShmPublisher::open(const std::string& name, uint32_t capacity) {
+    close();
+    capacity_ = round_up_pow2(capacity);
+    const size_t record_bytes = sizeof(pirtos_shm_record);
+    map_bytes_ = PIRTOS_SHM_HEADER_BYTES + static_cast<size_t>(capacity_) * record_bytes;
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0 && st.st_size != 0 &&
+        st.st_size != static_cast<off_t>(map_bytes_)) {
+        retire(fd);
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(map_bytes_)) < 0) {
+        std::cerr << "Shared-memory channel " << name << ": " << std::strerror(errno)
+                  << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    void* p = ::mmap(nullptr, map_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "Shared-memory channel " << name << ": mmap: " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    header_ = static_cast<pirtos_shm_header*>(p);
+    slots_ = static_cast<uint8_t*>(p) + PIRTOS_SHM_HEADER_BYTES;
+
+    // Take the ring over under the descriptor seqlock: readers of the same
+    // layout follow the new epoch from record 0.
+    pirtos_shm_header* h = header_;
+    uint64_t epoch = h->magic == PIRTOS_SHM_MAGIC && h->epoch != PIRTOS_SHM_EPOCH_RETIRED
+                         ? h->epoch + 1 : 1;
+    uint32_t seq = __atomic_load_n(&h->desc_seq, __ATOMIC_RELAXED) | 1u;
+    __atomic_store_n(&h->desc_seq, seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&h->write_seq, 0, __ATOMIC_RELAXED);
+    std::memset(slots_, 0, map_bytes_ - PIRTOS_SHM_HEADER_BYTES);
+    __atomic_store_n(&h->magic, PIRTOS_SHM_MAGIC, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->version, PIRTOS_SHM_VERSION, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->record_size, static_cast<uint32_t>(record_bytes), __ATOMIC_RELAXED);
+    __atomic_store_n(&h->capacity, capacity_, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->epoch, epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->desc_seq, seq + 1, __ATOMIC_RELEASE);
+    write_seq_ = 0;
+
+    std::cout << "Shared-memory channel " << name << " (" << capacity_ << " records, epoch "
+              << epoch << ")" << std::endl;
+    return true;
+}
+
+void ShmPublisher::close() {
+    if (header_) ::munmap(header_, map_bytes_);
+    header_ = nullptr;
+    slots_ = nullptr;
+}
+
+void ShmPublisher::publish(const SensorBatch& batch) {
+    if (!header_ || batch.empty()) return;
+    TRACE_SCOPE("shm.publish", batch.first_seq);
+    const uint64_t mask = capacity_ - 1;
+    for (uint32_t i = 0; i < batch.count; ++i) {
+        const uint64_t n = write_seq_ + i;
+        auto* rec = reinterpret_cast<pirtos_shm_record*>(slots_ + (n & mask) * sizeof(pirtos_shm_record));
+        __atomic_store_n(&rec->seq, 2 * n + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rec->sample_seq = batch.first_seq + i;
+        rec->timestamp_ns = batch.timestamp[i];
+        rec->temperature = batch.temperature[i];
+        rec->humidity = batch.humidity[i];
+        rec->flags = batch.flags[i];
+        __atomic_store_n(&rec->seq, 2 * n + 2, __ATOMIC_RELEASE);
+    }
+    write_seq_ += batch.count;
+    __atomic_store_n(&header_->write_seq, write_seq_, __ATOMIC_RELEASE);
+
+    // Pairs with pirtos_shm_wait(): bump, then wake only if someone sleeps
+    __atomic_add_fetch(&header_->futex, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header_->waiters, __ATOMIC_SEQ_CST) != 0) {
+        ::syscall(SYS_futex, &header_->futex, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
@@ -0,0 +1,103 @@
+// pirtos_shm_tail: follows the hub's shared-memory sample channel from
+// another process, using only the C reader library.
+//
+//   pirtos_shm_tail                        # live samples as they arrive
+//   pirtos_shm_tail --oldest --count 100   # backlog first, stop after 100
+//   pirtos_shm_tail --quiet --seconds 10   # rate and overrun summary only
+
+#include "pirtos_shm.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --name NAME     ring name (default /pirtos_samples)\n"
+            "  --oldest        start with the oldest record still in the ring\n"
+            "  --count N       exit after N records\n"
+            "  --seconds S     exit after S seconds\n"
+            "  --quiet         print only the summary\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* name = "/pirtos_samples";
+    int oldest = 0, quiet = 0;
+    uint64_t count = 0;
+    double seconds = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--name") && i + 1 < argc) name = argv[++i];
+        else if (!strcmp(argv[i], "--oldest")) oldest = 1;
+        else if (!strcmp(argv[i], "--count") && i + 1 < argc) count = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--quiet")) quiet = 1;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    pirtos_shm_reader reader;
+    int rc = pirtos_shm_open(&reader, name);
+    if (rc < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", name, strerror(-rc));
+        return 1;
+    }
+    if (oldest) pirtos_shm_seek_oldest(&reader);
+
+    struct pirtos_shm_record records[64];
+    uint64_t total = 0, overruns = 0, reopened = 0;
+    const double start = now_s();
+    while (running && (!count || total < count) && (seconds <= 0.0 || now_s() - start < seconds)) {
+        if (!pirtos_shm_wait(&reader, 200)) continue;
+        int n = pirtos_shm_read(&reader, records, 64);
+        if (n == -ESTALE) {
+            // The hub restarted with a different ring size
+            overruns += reader.overruns;
+            pirtos_shm_close(&reader);
+            if (pirtos_shm_open(&reader, name) < 0) break;
+            ++reopened;
+            continue;
+        }
+        for (int i = 0; i < n && (!count || total < count); ++i, ++total) {
+            if (quiet) continue;
+            const struct pirtos_shm_record* r = &records[i];
+            printf("%" PRIu64 " ts=%" PRIu64 " temp=%.2fC hum=%.2f%% motion=%d button=%d\n",
+                   r->sample_seq, r->timestamp_ns, r->temperature, r->humidity,
+                   (r->flags & PIRTOS_SHM_FLAG_MOTION) != 0,
+                   (r->flags & PIRTOS_SHM_FLAG_BUTTON) != 0);
+        }
+        if (!quiet) fflush(stdout);
+    }
+    overruns += reader.overruns;
+    double elapsed = now_s() - start;
+    pirtos_shm_close(&reader);
+
+    fprintf(stderr, "%" PRIu64 " records in %.1f s (%.0f/s), %" PRIu64 " lost to overruns",
+            total, elapsed, elapsed > 0 ? total / elapsed : 0.0, overruns);
+    if (reopened) fprintf(stderr, ", reopened %" PRIu64 " times", reopened);
+    fprintf(stderr, "\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "time_aligner.h"
+
+#include <algorithm>
+
+namespace {
+// Grid point at or after `t`: observations sharing it lie in one grid cell
+uint64_t cell_of(uint64_t t, uint64_t period) { return (t + period - 1) / period; }
+
+bool is_state(int channel) {
+    return channel == static_cast<int>(AlignChannel::Motion) ||
+           channel == static_cast<int>(AlignChannel::Button);
+}
+}
+
+TimeAligner::TimeAligner(const TimeAlignerConfig& config)
+    : config_(config),
+      fill_{config.temperature, config.humidity, TimeAlignerConfig::Fill::Hold,
+            TimeAlignerConfig::Fill::Hold} {
+    if (config_.period_ns == 0) config_.period_ns = 1;
+    reset();
+}
+
+void TimeAligner::reset() {
+    for (Stream& s : streams_) s.count = 0;
+    have_input_ = false;
+    have_prev_ = false;
+    max_timestamp_ = 0;
+    next_grid_ = 0;
+    have_passed_ = false;
+    passed_ = 0;
+    prev_temperature_ = 0.0f;
+    prev_humidity_ = 0.0f;
+    prev_flags_ = 0;
+    records_out_ = 0;
+    late_ = 0;
+    overflowed_ = 0;
+}
+
+uint64_t TimeAligner::watermark() const {
+    return max_timestamp_ > config_.lateness_ns ? max_timestamp_ - config_.lateness_ns : 0;
+}
+
+void TimeAligner::push(AlignChannel channel, uint64_t timestamp, float value) {
+    const uint64_t period = config_.period_ns;
+    Stream& s = streams_[static_cast<int>(channel)];
+
+    if (!have_passed_) {
+        // Start the grid at the earliest observation seen so far
+        uint64_t first = cell_of(timestamp, period) * period;
+        if (!have_input_ || first < next_grid_) next_grid_ = first;
+    }
+    have_input_ = true;
+    max_timestamp_ = std::max(max_timestamp_, timestamp);
+
+    bool late = have_passed_ && timestamp <= passed_;
+    if (late) {
+        // Records up to passed_ are out already; the value still holds from
+        // here on if nothing newer is buffered for this channel.
+        ++late_;
+        if (s.count > 0 && s.obs[s.count - 1].timestamp > timestamp) return;
+    }
+
+    // Usual case: in order. Of the observations in one grid cell only the
+    // first and last can bracket a grid point, so replace the middle one.
+    // A state keeps an active observation instead of the first, so the
+    // cell still shows a pulse that has already ended.
+    if (s.count == 0 || s.obs[s.count - 1].timestamp <= timestamp) {
+        if (s.count >= 2 && !late) {
+            uint64_t cell = cell_of(timestamp, period);
+            if (cell_of(s.obs[s.count - 1].timestamp, period) == cell &&
+                cell_of(s.obs[s.count - 2].timestamp, period) == cell) {
+                if (is_state(static_cast<int>(channel)) && s.obs[s.count - 1].value != 0.0f) {
+                    s.obs[s.count - 2] = s.obs[s.count - 1];
+                }
+                s.obs[s.count - 1] = Observation{timestamp, value};
+                return;
+            }
+        }
+        if (s.count == kDepth) {
+            ++overflowed_;
+            return;
+        }
+        s.obs[s.count++] = Observation{timestamp, value};
+        return;
+    }
+
+    // Out of order within the lateness bound: sorted insert
+    if (s.count == kDepth) {
+        ++overflowed_;
+        return;
+    }
+    size_t i = s.count;
+    while (i > 0 && s.obs[i - 1].timestamp > timestamp) {
+        s.obs[i] = s.obs[i - 1];
+        --i;
+    }
+    s.obs[i] = Observation{timestamp, value};
+    ++s.count;
+}
+
+void TimeAligner::ingest(const SensorBatch& in) {
+    for (uint32_t i = 0; i < in.count; ++i) {
+        uint64_t ts = in.timestamp[i];
+        float t = in.temperature[i];
+        float h = in.humidity[i];
+        uint8_t f = in.flags[i];
+
+        bool changed = have_prev_ && f != prev_flags_;
+        if (!have_prev_ || ((f ^ prev_flags_) & SENSOR_FLAG_MOTION)) {
+            push(AlignChannel::Motion, ts, (f & SENSOR_FLAG_MOTION) ? 1.0f : 0.0f);
+        }
+        if (!have_prev_ || ((f ^ prev_flags_) & SENSOR_FLAG_BUTTON)) {
+            push(AlignChannel::Button, ts, (f & SENSOR_FLAG_BUTTON) ? 1.0f : 0.0f);
+        }
+        if (!changed || t != prev_temperature_) push(AlignChannel::Temperature, ts, t);
+        if (!changed || h != prev_humidity_) push(AlignChannel::Humidity, ts, h);
+
+        have_prev_ = true;
+        prev_temperature_ = t;
+        prev_humidity_ = h;
+        prev_flags_ = f;
+    }
+}
+
+bool TimeAligner::sample(int channel, uint64_t grid, float& value, bool& stale) const {
+    const Stream& s = streams_[channel];
+    size_t i = s.count;
+    while (i > 0 && s.obs[i - 1].timestamp > grid) --i;
+    stale = false;
+    if (i == 0) {
+        // States start released; continuous channels have no value yet
+        value = 0.0f;
+        return is_state(channel);
+    }
+
+    const Observation& a = s.obs[i - 1];
+    value = a.value;
+    if (is_state(channel)) {
+        // Active at any instant of the cell (grid - period, grid]: the value
+        // the cell started with or any reading inside it. prune() keeps the
+        // newest reading at or before the previous grid point.
+        const uint64_t start = grid > config_.period_ns ? grid - config_.period_ns : 0;
+        for (size_t j = i; j-- > 0 && value == 0.0f;) {
+            value = s.obs[j].value;
+            if (s.obs[j].timestamp <= start) break;
+        }
+        return true;
+    }
+
+    uint64_t span = grid - a.timestamp;
+    if (fill_[channel] == TimeAlignerConfig::Fill::Interpolate && i < s.count) {
+        const Observation& b = s.obs[i];
+        double frac = static_cast<double>(grid - a.timestamp) /
+                      static_cast<double>(b.timestamp - a.timestamp);
+        value = static_cast<float>(a.value + (b.value - a.value) * frac);
+        span = b.timestamp - a.timestamp;
+    }
+    stale = config_.max_gap_ns != 0 && span > config_.max_gap_ns;
+    return true;
+}
+
+void TimeAligner::emit(uint64_t grid, SensorBatch& out) {
+    float value[kChannels];
+    bool any_stale = false;
+    for (int c = 0; c < kChannels; ++c) {
+        bool stale;
+        if (!sample(c, grid, value[c], stale)) return;  // before first reading
+        any_stale |= stale;
+    }
+
+    uint32_t i = out.count++;
+    out.timestamp[i] = grid;
+    out.temperature[i] = value[static_cast<int>(AlignChannel::Temperature)];
+    out.humidity[i] = value[static_cast<int>(AlignChannel::Humidity)];
+    out.flags[i] = static_cast<uint8_t>(
+        (value[static_cast<int>(AlignChannel::Motion)] != 0.0f ? SENSOR_FLAG_MOTION : 0) |
+        (value[static_cast<int>(AlignChannel::Button)] != 0.0f ? SENSOR_FLAG_BUTTON : 0) |
+        (any_stale ? SENSOR_FLAG_STALE : 0));
+    ++records_out_;
+}
+
+void TimeAligner::prune(uint64_t grid) {
+    // Keep the newest observation at or before the grid point: it is the
+    // left bracket (or held value) for the next one.
+    for (Stream& s : streams_) {
+        size_t keep_from = 0;
+        while (keep_from + 1 < s.count && s.obs[keep_from + 1].timestamp <= grid) ++keep_from;
+        if (keep_from == 0) continue;
+        std::copy(s.obs + keep_from, s.obs + s.count, s.obs);
+        s.count -= keep_from;
+    }
+}
+
+uint32_t TimeAligner::emit_until(uint64_t limit, SensorBatch& out) {
+    uint32_t before = out.count;
+    while (have_input_ && next_grid_ <= limit && !out.full()) {
+        emit(next_grid_, out);
+        prune(next_grid_);
+        passed_ = next_grid_;
+        have_passed_ = true;
+        next_grid_ += config_.period_ns;
+    }
+    return out.count - before;
+}
+
+uint32_t TimeAligner::drain(SensorBatch& out) { return emit_until(watermark(), out); }
+
+uint32_t TimeAligner::flush(SensorBatch& out) { return emit_until(max_timestamp_, out); }
@@ -0,0 +1,186 @@
+#include "trace.h"
+#include "common.h"
+
+#include <memory>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+constexpr size_t kBufferEvents = 1u << 13;
+
+// Single-producer (owning thread) / single-consumer (TraceWriter) ring.
+struct ThreadBuffer {
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};     // owning thread exited; writer frees it
+    const char* exported_name = nullptr;  // writer-side bookkeeping
+    int tid = 0;
+    Event events[kBufferEvents];
+};
+
+struct Registry {
+    std::mutex m;
+    // Buffers outlive their threads so late events still get exported; the
+    // writer frees a retired buffer once it has drained it.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint64_t retired_dropped = 0;  // drop counts of freed buffers
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+// Buffers are only allocated once a thread records, so threads cost nothing
+// while tracing stays off.
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local const char* t_name = nullptr;
+
+// Hands the thread's buffer to the writer when the thread exits. Only
+// constructed by threads that record, so t_buffer itself stays a plain
+// pointer with no TLS guard on the recording path.
+struct BufferRetirer {
+    ~BufferRetirer() {
+        if (t_buffer) t_buffer->retired.store(true, std::memory_order_release);
+        t_buffer = nullptr;
+    }
+};
+
+ThreadBuffer* thread_buffer() {
+    if (!t_buffer) {
+        static thread_local BufferRetirer retirer;
+        (void)retirer;
+        auto buf = std::make_unique<ThreadBuffer>();
+        buf->tid = static_cast<int>(::syscall(SYS_gettid));
+        buf->name.store(t_name, std::memory_order_relaxed);
+        t_buffer = buf.get();
+        std::lock_guard<std::mutex> lock(registry().m);
+        registry().buffers.push_back(std::move(buf));
+    }
+    return t_buffer;
+}
+
+void write_event(std::FILE* f, bool& first, int tid, const Event& e) {
+    std::fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                 first ? "" : ",", e.name, static_cast<char>(e.phase), e.ts_ns / 1000.0, tid);
+    first = false;
+
+    switch (e.phase) {
+    case Phase::Instant:
+        std::fputs(",\"s\":\"t\"", f);
+        break;
+    case Phase::FlowStart:
+    case Phase::FlowStep:
+        std::fprintf(f, ",\"cat\":\"sample\",\"id\":%llu", static_cast<unsigned long long>(e.seq));
+        break;
+    case Phase::FlowEnd:
+        std::fprintf(f, ",\"cat\":\"sample\",\"id\":%llu,\"bp\":\"e\"",
+                     static_cast<unsigned long long>(e.seq));
+        break;
+    default:
+        break;
+    }
+    std::fprintf(f, ",\"args\":{\"seq\":%llu}}", static_cast<unsigned long long>(e.seq));
+}
+
+} // namespace
+
+void set_enabled(bool on) { g_enabled.store(on, std::memory_order_relaxed); }
+
+void set_thread_name(const char* name) {
+    t_name = name;
+    if (t_buffer) t_buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void record(const char* name, Phase phase, uint64_t seq) {
+    ThreadBuffer* buf = thread_buffer();
+    uint64_t head = buf->head.load(std::memory_order_relaxed);
+    if (head - buf->tail.load(std::memory_order_acquire) >= kBufferEvents) {
+        buf->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buf->events[head % kBufferEvents] = Event{monotonic_ns(), seq, name, phase};
+    buf->head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t dropped() {
+    std::lock_guard<std::mutex> lock(registry().m);
+    uint64_t total = registry().retired_dropped;
+    for (auto& buf : registry().buffers) total += buf->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t thread_buffers() {
+    std::lock_guard<std::mutex> lock(registry().m);
+    return registry().buffers.size();
+}
+
+bool TraceWriter::open(const std::string& path) {
+    close();
+    file_ = std::fopen(path.c_str(), "w");
+    if (!file_) return false;
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file_);
+    first_ = true;
+
+    // Re-announce thread names in every file
+    std::lock_guard<std::mutex> lock(registry().m);
+    for (auto& buf : registry().buffers) buf->exported_name = nullptr;
+    return true;
+}
+
+size_t TraceWriter::flush() {
+    if (!file_) return 0;
+
+    size_t written = 0;
+    std::lock_guard<std::mutex> lock(registry().m);
+    auto& buffers = registry().buffers;
+    for (size_t i = 0; i < buffers.size();) {
+        ThreadBuffer* buf = buffers[i].get();
+        // Read before head: a retired thread records nothing more, so this
+        // drain is its last
+        bool retired = buf->retired.load(std::memory_order_acquire);
+        const char* name = buf->name.load(std::memory_order_relaxed);
+        if (name && name != buf->exported_name) {
+            std::fprintf(file_, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                         "\"args\":{\"name\":\"%s\"}}", first_ ? "" : ",", buf->tid, name);
+            first_ = false;
+            buf->exported_name = name;
+        }
+
+        uint64_t tail = buf->tail.load(std::memory_order_relaxed);
+        uint64_t head = buf->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail, ++written) {
+            write_event(file_, first_, buf->tid, buf->events[tail % kBufferEvents]);
+        }
+        buf->tail.store(tail, std::memory_order_release);
+
+        if (retired) {
+            registry().retired_dropped += buf->dropped.load(std::memory_order_relaxed);
+            buffers[i] = std::move(buffers.back());
+            buffers.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    std::fflush(file_);
+    return written;
+}
+
+void TraceWriter::close() {
+    if (!file_) return;
+    flush();
+    std::fputs("\n]}\n", file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+} // namespace trace